@@ -0,0 +1,182 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// A minimal benchmark harness shared by the benchmarks in this directory.
+// Every benchmark accepts:
+//   --json          print results as JSON instead of a table
+//   --min-time=S    run each case for at least S seconds (default 0.25)
+//   --filter=TEXT   only run cases whose group or name contains TEXT
+// Within a group the case named "raw" is the hand-written C API baseline
+// and every other case is reported relative to it. Groups without a raw
+// case are reported relative to their first case instead.
+
+#pragma once
+
+#include <sqlitexx/connection.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+enum class storage {
+    memory,
+    wal
+};
+
+inline const char* to_string(storage s) noexcept {
+    return s == storage::memory ? "memory" : "wal";
+}
+
+inline void remove_database(const std::string& filename) {
+    std::remove(filename.c_str());
+    std::remove((filename + "-wal").c_str());
+    std::remove((filename + "-shm").c_str());
+}
+
+// opens a fresh database, a WAL database on disk lives in the working directory
+inline sqlite::connection open(storage s, const char* filename = "sqlitexx_bench.db") {
+    int flags = sqlite::connection::read_write | sqlite::connection::create;
+    if(s == storage::memory) {
+        return sqlite::connection(":memory:", flags);
+    }
+
+    remove_database(filename);
+    sqlite::connection con(filename, flags);
+    con.execute("PRAGMA journal_mode = WAL; PRAGMA synchronous = NORMAL;");
+    return con;
+}
+
+struct result {
+    std::string group;
+    std::string name;
+    std::string database;
+    uint64_t ops;
+    double seconds;
+
+    double ns_per_op() const noexcept {
+        return seconds * 1e9 / static_cast<double>(ops);
+    }
+};
+
+struct suite {
+    suite(int argc, char** argv) {
+        for(int i = 1; i < argc; ++i) {
+            if(std::strcmp(argv[i], "--json") == 0) {
+                json = true;
+            }
+            else if(std::strncmp(argv[i], "--min-time=", 11) == 0) {
+                min_time = std::atof(argv[i] + 11);
+            }
+            else if(std::strncmp(argv[i], "--filter=", 9) == 0) {
+                filter = argv[i] + 9;
+            }
+            else {
+                positional.emplace_back(argv[i]);
+            }
+        }
+    }
+
+    // the non-option arguments, for benchmarks that take their own parameters
+    const std::vector<std::string>& arguments() const noexcept {
+        return positional;
+    }
+
+    bool enabled(const std::string& group, const std::string& name) const {
+        return filter.empty() || group.find(filter) != std::string::npos || name.find(filter) != std::string::npos;
+    }
+
+    // f performs ops operations per call and is called repeatedly until min_time passes
+    template<typename F>
+    void run(const std::string& group, const std::string& name, storage db, uint64_t ops, F&& f) {
+        if(!enabled(group, name)) {
+            return;
+        }
+
+        f();
+        uint64_t total = 0;
+        auto start = std::chrono::steady_clock::now();
+        std::chrono::duration<double> elapsed{0};
+        do {
+            f();
+            total += ops;
+            elapsed = std::chrono::steady_clock::now() - start;
+        }
+        while(elapsed.count() < min_time);
+
+        results.push_back({ group, name, to_string(db), total, elapsed.count() });
+        if(!json) {
+            print(results.back());
+        }
+    }
+
+    int report() const {
+        if(!json) {
+            return 0;
+        }
+
+        std::printf("{\n  \"benchmarks\": [\n");
+        for(size_t i = 0; i < results.size(); ++i) {
+            auto&& r = results[i];
+            std::printf("    {\"group\": \"%s\", \"name\": \"%s\", \"database\": \"%s\", \"ops\": %llu, "
+                        "\"seconds\": %.9f, \"ns_per_op\": %.3f, \"baseline_ratio\": %.4f}%s\n",
+                        r.group.c_str(), r.name.c_str(), r.database.c_str(), static_cast<unsigned long long>(r.ops),
+                        r.seconds, r.ns_per_op(), ratio(r), i + 1 == results.size() ? "" : ",");
+        }
+        std::printf("  ]\n}\n");
+        return 0;
+    }
+private:
+    // relative to the raw case of the same group and database, or the first case if there isn't one
+    double ratio(const result& r) const {
+        auto same_group = [&](const result& other) {
+            return other.group == r.group && other.database == r.database;
+        };
+        auto it = std::find_if(results.begin(), results.end(), [&](const result& other) {
+            return same_group(other) && other.name == "raw";
+        });
+        if(it == results.end()) {
+            it = std::find_if(results.begin(), results.end(), same_group);
+        }
+        return r.ns_per_op() / it->ns_per_op();
+    }
+
+    void print(const result& r) const {
+        std::printf("%-18s %-22s %-7s %12.2f ns/op %14.0f ops/sec  x%.2f\n", r.group.c_str(), r.name.c_str(),
+                    r.database.c_str(), r.ns_per_op(), 1e9 / r.ns_per_op(), ratio(r));
+        std::fflush(stdout);
+    }
+
+    std::vector<result> results;
+    std::vector<std::string> positional;
+    std::string filter;
+    double min_time = 0.25;
+    bool json = false;
+};
+} // bench
@@ -0,0 +1,103 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// Compares bulk_writer against the naive statement::execute loop and the raw C API.
+// usage: bench_bulk_insert [rows] [--json] [--min-time=S] [--filter=TEXT]
+
+#include "bench.hpp"
+
+#include <sqlitexx/bulk.hpp>
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+using row_type = std::tuple<long long, double, std::string>;
+
+const char insert[] = "INSERT INTO data(id, value, name) VALUES (?, ?, ?);";
+
+void run(bench::suite& s, bench::storage db, const std::vector<row_type>& rows) {
+    auto con = bench::open(db);
+    con.execute("CREATE TABLE data(id INTEGER PRIMARY KEY, value REAL, name TEXT);");
+    auto clear = con.prepare("DELETE FROM data;");
+    auto n = rows.size();
+
+    s.run("bulk_insert", "raw", db, n, [&] {
+        clear.execute();
+        sqlite3_stmt* ptr;
+        sqlite3_prepare_v2(con.data(), insert, -1, &ptr, nullptr);
+        sqlite3_exec(con.data(), "BEGIN;", nullptr, nullptr, nullptr);
+        for(auto&& row : rows) {
+            auto&& name = std::get<2>(row);
+            sqlite3_bind_int64(ptr, 1, std::get<0>(row));
+            sqlite3_bind_double(ptr, 2, std::get<1>(row));
+            sqlite3_bind_text(ptr, 3, name.c_str(), static_cast<int>(name.size()), SQLITE_TRANSIENT);
+            sqlite3_step(ptr);
+            sqlite3_reset(ptr);
+        }
+        sqlite3_exec(con.data(), "COMMIT;", nullptr, nullptr, nullptr);
+        sqlite3_finalize(ptr);
+    });
+
+    s.run("bulk_insert", "execute_loop", db, n, [&] {
+        clear.execute();
+        auto tx = con.transaction();
+        auto stmt = con.prepare(insert);
+        for(auto&& row : rows) {
+            stmt.execute(std::get<0>(row), std::get<1>(row), std::get<2>(row));
+        }
+        tx.commit();
+    });
+
+    s.run("bulk_insert", "bulk_writer", db, n, [&] {
+        clear.execute();
+        sqlite::bulk_writer writer(con, "data", { "id", "value", "name" });
+        writer.write(rows);
+    });
+
+    s.run("bulk_insert", "bulk_writer_multi", db, n, [&] {
+        clear.execute();
+        sqlite::bulk_options opts;
+        opts.multi_row = true;
+        sqlite::bulk_writer writer(con, "data", { "id", "value", "name" }, opts);
+        writer.write(rows);
+    });
+}
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    bench::suite s(argc, argv);
+    size_t count = s.arguments().empty() ? 100000 : std::stoul(s.arguments()[0]);
+
+    std::vector<row_type> rows;
+    rows.reserve(count);
+    for(size_t i = 0; i < count; ++i) {
+        rows.emplace_back(static_cast<long long>(i), i * 0.5, "name " + std::to_string(i));
+    }
+
+    run(s, bench::storage::memory, rows);
+    run(s, bench::storage::wal, rows);
+    bench::remove_database("sqlitexx_bench.db");
+    return s.report();
+}
@@ -0,0 +1,157 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// Compares SQLite's memory configurations on an allocation heavy workload:
+// preparing, running and finalizing a small query and inserting text rows.
+
+#include "bench.hpp"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+// A minimal size class cache in front of malloc to show off config::allocator.
+// Freed blocks of up to 1KiB are kept per thread and never given back.
+struct caching_allocator {
+    static const size_t granularity = 64;
+    static const size_t classes = 16;
+
+    struct node {
+        node* next;
+    };
+
+    static node*& free_list(size_t index) noexcept {
+        static thread_local node* lists[classes] = {};
+        return lists[index];
+    }
+
+    static size_t size_class(size_t size) noexcept {
+        return (size + granularity - 1) / granularity;
+    }
+
+    void* allocate(size_t size) {
+        size_t index = size_class(size);
+        if(index < classes) {
+            auto&& head = free_list(index);
+            if(head != nullptr) {
+                auto ptr = head;
+                head = head->next;
+                return ptr;
+            }
+            return std::malloc(index * granularity);
+        }
+        return std::malloc(size);
+    }
+
+    void deallocate(void* ptr, size_t size) noexcept {
+        size_t index = size_class(size);
+        if(index < classes) {
+            auto block = static_cast<node*>(ptr);
+            block->next = free_list(index);
+            free_list(index) = block;
+            return;
+        }
+        std::free(ptr);
+    }
+};
+
+struct setup {
+    const char* name;
+    bool memory_status;
+    int lookaside_size;
+    int lookaside_slots;
+    bool custom_allocator;
+};
+
+// lookaside_slots < 0 keeps the connection's default lookaside
+const setup setups[] = {
+    { "default",           true,  0,    -1,  false },
+    { "memstatus_off",     false, 0,    -1,  false },
+    { "lookaside_off",     true,  0,    0,   false },
+    { "lookaside_large",   true,  256,  1024, false },
+    { "caching_allocator", true,  0,    -1,  true }
+};
+
+caching_allocator allocator;
+
+void configure(const setup& s) {
+    sqlite3_shutdown();
+    sqlite::config::memory_status(s.memory_status);
+    if(s.custom_allocator) {
+        sqlite::config::allocator(allocator);
+    }
+    else {
+        sqlite::config::default_allocator();
+    }
+    sqlite3_initialize();
+}
+
+void run(bench::suite& s, bench::storage db, const setup& config) {
+    configure(config);
+    auto con = bench::open(db);
+    if(config.lookaside_slots >= 0) {
+        con.set_lookaside(config.lookaside_size, config.lookaside_slots);
+    }
+
+    con.execute("CREATE TABLE data(id INTEGER PRIMARY KEY, name TEXT);"
+                "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c WHERE x < 1000) "
+                "INSERT INTO data SELECT x, 'name ' || x FROM c;");
+
+    const int ops = 1000;
+    volatile size_t sink = 0;
+    s.run("prepare_query", config.name, db, ops, [&] {
+        for(int i = 0; i < ops; ++i) {
+            auto stmt = con.prepare("SELECT id, name FROM data WHERE id = ?;");
+            stmt.bind(i % 1000 + 1);
+            for(auto&& row : stmt.fetch<long long, std::string>()) {
+                sink = sink + row.get<1>().size();
+            }
+        }
+    });
+
+    auto insert = con.prepare("INSERT INTO data(name) VALUES (?);");
+    std::string text(100, 'x');
+    s.run("insert_text", config.name, db, ops, [&] {
+        auto tx = con.transaction();
+        for(int i = 0; i < ops; ++i) {
+            insert.execute(text);
+        }
+        tx.commit();
+    });
+}
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    bench::suite s(argc, argv);
+    for(auto db : { bench::storage::memory, bench::storage::wal }) {
+        for(auto&& config : setups) {
+            run(s, db, config);
+        }
+    }
+
+    sqlite3_shutdown();
+    sqlite::config::default_allocator();
+    bench::remove_database("sqlitexx_bench.db");
+    return s.report();
+}
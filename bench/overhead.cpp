@@ -0,0 +1,464 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// Measures the wrapper against hand-written sqlite3_* calls for the common operations.
+
+#include "bench.hpp"
+
+#include <sqlitexx/bulk.hpp>
+
+#include <chrono>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+const int table_rows = 10000;
+
+void populate(const sqlite::connection& con) {
+    con.execute("CREATE TABLE data(id INTEGER PRIMARY KEY, value REAL, name TEXT, payload BLOB);"
+                "CREATE TABLE sink(id INTEGER PRIMARY KEY, value REAL, name TEXT);"
+                "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c WHERE x < 10000) "
+                "INSERT INTO data SELECT x, x * 0.5, 'name ' || x, randomblob(32) FROM c;");
+}
+
+// a finalizing RAII holder for the raw baselines
+struct raw_statement {
+    raw_statement(sqlite3* db, const char* sql) {
+        sqlite3_prepare_v2(db, sql, -1, &ptr, nullptr);
+    }
+
+    ~raw_statement() {
+        sqlite3_finalize(ptr);
+    }
+
+    sqlite3_stmt* ptr = nullptr;
+};
+
+void prepare(bench::suite& s, bench::storage db, sqlite::connection& con) {
+    const char sql[] = "SELECT id, value, name FROM data WHERE id = ?;";
+    const int n = 1000;
+    s.run("prepare", "raw", db, n, [&] {
+        for(int i = 0; i < n; ++i) {
+            sqlite3_stmt* ptr;
+            sqlite3_prepare_v2(con.data(), sql, sizeof(sql) - 1, &ptr, nullptr);
+            sqlite3_finalize(ptr);
+        }
+    });
+
+    s.run("prepare", "statement", db, n, [&] {
+        for(int i = 0; i < n; ++i) {
+            auto stmt = con.prepare(sql);
+        }
+    });
+
+    con.enable_statement_cache();
+    s.run("prepare", "prepare_cached", db, n, [&] {
+        for(int i = 0; i < n; ++i) {
+            auto stmt = con.prepare_cached(sql);
+        }
+    });
+    con.disable_statement_cache();
+}
+
+void bind(bench::suite& s, bench::storage db, const sqlite::connection& con) {
+    const int n = 1000;
+    std::string text = "a moderately sized text parameter";
+    {
+        raw_statement raw(con.data(), "SELECT ?, ?, ?;");
+        s.run("bind_positional", "raw", db, n, [&] {
+            for(int i = 0; i < n; ++i) {
+                sqlite3_bind_int64(raw.ptr, 1, i);
+                sqlite3_bind_double(raw.ptr, 2, i * 0.5);
+                sqlite3_bind_text(raw.ptr, 3, text.c_str(), static_cast<int>(text.size()), SQLITE_TRANSIENT);
+            }
+        });
+    }
+
+    auto stmt = con.prepare("SELECT ?, ?, ?;");
+    s.run("bind_positional", "bind", db, n, [&] {
+        for(int i = 0; i < n; ++i) {
+            stmt.bind(static_cast<long long>(i), i * 0.5, text);
+        }
+    });
+
+    s.run("bind_positional", "bind_static", db, n, [&] {
+        for(int i = 0; i < n; ++i) {
+            stmt.bind(static_cast<long long>(i), i * 0.5, sqlite::bind_static(text));
+        }
+    });
+
+    {
+        raw_statement raw(con.data(), "SELECT :id, :value, :name;");
+        int id = sqlite3_bind_parameter_index(raw.ptr, ":id");
+        int value = sqlite3_bind_parameter_index(raw.ptr, ":value");
+        int name = sqlite3_bind_parameter_index(raw.ptr, ":name");
+        s.run("bind_named", "raw", db, n, [&] {
+            for(int i = 0; i < n; ++i) {
+                sqlite3_bind_int64(raw.ptr, id, i);
+                sqlite3_bind_double(raw.ptr, value, i * 0.5);
+                sqlite3_bind_text(raw.ptr, name, text.c_str(), static_cast<int>(text.size()), SQLITE_TRANSIENT);
+            }
+        });
+    }
+
+    auto named = con.prepare("SELECT :id, :value, :name;");
+    s.run("bind_named", "by_name", db, n, [&] {
+        for(int i = 0; i < n; ++i) {
+            named.bind(sqlite::named(":id", static_cast<long long>(i)),
+                       sqlite::named(":value", i * 0.5),
+                       sqlite::named(":name", text));
+        }
+    });
+
+    auto plan = named.slots(":id", ":value", ":name");
+    s.run("bind_named", "param_slot", db, n, [&] {
+        for(int i = 0; i < n; ++i) {
+            named.bind_to(plan[0], static_cast<long long>(i));
+            named.bind_to(plan[1], i * 0.5);
+            named.bind_to(plan[2], text);
+        }
+    });
+}
+
+void step(bench::suite& s, bench::storage db, const sqlite::connection& con) {
+    raw_statement raw(con.data(), "SELECT id, value, name, payload FROM data;");
+    s.run("step", "raw", db, table_rows, [&] {
+        sqlite3_reset(raw.ptr);
+        int rows = 0;
+        while(sqlite3_step(raw.ptr) == SQLITE_ROW) {
+            ++rows;
+        }
+        return rows;
+    });
+
+    auto stmt = con.prepare("SELECT id, value, name, payload FROM data;");
+    s.run("step", "fetch", db, table_rows, [&] {
+        int rows = 0;
+        for(auto&& row : stmt.fetch<>()) {
+            (void)row;
+            ++rows;
+        }
+        return rows;
+    });
+}
+
+void point_query(bench::suite& s, bench::storage db, const sqlite::connection& con) {
+    const char sql[] = "SELECT value, name FROM data WHERE id = ?;";
+    const int n = 1000;
+    volatile double sink = 0;
+    {
+        raw_statement raw(con.data(), sql);
+        s.run("point_query", "raw", db, n, [&] {
+            for(int i = 0; i < n; ++i) {
+                sqlite3_reset(raw.ptr);
+                sqlite3_bind_int64(raw.ptr, 1, i % table_rows + 1);
+                while(sqlite3_step(raw.ptr) == SQLITE_ROW) {
+                    sink = sink + sqlite3_column_double(raw.ptr, 0) + sqlite3_column_bytes(raw.ptr, 1);
+                }
+            }
+        });
+    }
+
+    auto stmt = con.prepare(sql);
+    s.run("point_query", "statement", db, n, [&] {
+        for(int i = 0; i < n; ++i) {
+            stmt.reset();
+            stmt.bind(static_cast<long long>(i % table_rows + 1));
+            for(auto&& row : stmt.fetch<double, const char*>()) {
+                sink = sink + row.get<0>() + (row.get<1>() != nullptr);
+            }
+        }
+    });
+
+    auto typed = con.prepare_typed<sqlite::params(long long), sqlite::row(double, const char*)>(sql);
+    s.run("point_query", "typed_statement", db, n, [&] {
+        for(int i = 0; i < n; ++i) {
+            for(auto&& row : typed.fetch(i % table_rows + 1)) {
+                sink = sink + row.get<0>() + (row.get<1>() != nullptr);
+            }
+        }
+    });
+}
+
+template<typename T>
+void decode(bench::suite& s, bench::storage db, const sqlite::connection& con, const char* group, const char* column, T (*raw_decode)(sqlite3_stmt*)) {
+    std::string sql = std::string("SELECT ") + column + " FROM data;";
+    raw_statement raw(con.data(), sql.c_str());
+    volatile size_t sink = 0;
+    s.run(group, "raw", db, table_rows, [&] {
+        sqlite3_reset(raw.ptr);
+        while(sqlite3_step(raw.ptr) == SQLITE_ROW) {
+            sink = sink + static_cast<size_t>(raw_decode(raw.ptr));
+        }
+    });
+
+    auto stmt = con.prepare(sql);
+    s.run(group, "fetch", db, table_rows, [&] {
+        for(auto&& row : stmt.fetch<T>()) {
+            sink = sink + static_cast<size_t>(row.template get<0>());
+        }
+    });
+}
+
+void decode_text(bench::suite& s, bench::storage db, const sqlite::connection& con) {
+    const char sql[] = "SELECT name FROM data;";
+    raw_statement raw(con.data(), sql);
+    volatile size_t sink = 0;
+    s.run("decode_text", "raw", db, table_rows, [&] {
+        sqlite3_reset(raw.ptr);
+        std::string value;
+        while(sqlite3_step(raw.ptr) == SQLITE_ROW) {
+            auto str = reinterpret_cast<const char*>(sqlite3_column_text(raw.ptr, 0));
+            value.assign(str, static_cast<size_t>(sqlite3_column_bytes(raw.ptr, 0)));
+            sink = sink + value.size();
+        }
+    });
+
+    auto stmt = con.prepare(sql);
+    s.run("decode_text", "std::string", db, table_rows, [&] {
+        for(auto&& row : stmt.fetch<std::string>()) {
+            sink = sink + row.get<0>().size();
+        }
+    });
+
+    s.run("decode_text", "const char*", db, table_rows, [&] {
+        for(auto&& row : stmt.fetch<const char*>()) {
+            sink = sink + (row.get<0>() != nullptr);
+        }
+    });
+
+#if SQLITEXX_HAS_STRING_VIEW
+    s.run("decode_text", "std::string_view", db, table_rows, [&] {
+        for(auto&& row : stmt.fetch<std::string_view>()) {
+            sink = sink + row.get<0>().size();
+        }
+    });
+#endif
+
+    raw_statement raw_blob(con.data(), "SELECT payload FROM data;");
+    s.run("decode_blob", "raw", db, table_rows, [&] {
+        sqlite3_reset(raw_blob.ptr);
+        while(sqlite3_step(raw_blob.ptr) == SQLITE_ROW) {
+            auto data = sqlite3_column_blob(raw_blob.ptr, 0);
+            sink = sink + static_cast<size_t>(sqlite3_column_bytes(raw_blob.ptr, 0)) + (data != nullptr);
+        }
+    });
+
+    auto blobs = con.prepare("SELECT payload FROM data;");
+    s.run("decode_blob", "fetch", db, table_rows, [&] {
+        for(auto&& row : blobs.fetch<sqlite::blob>()) {
+            auto value = row.get<0>();
+            sink = sink + static_cast<size_t>(value.length) + (value.data != nullptr);
+        }
+    });
+}
+
+void decode_dynamic(bench::suite& s, bench::storage db, const sqlite::connection& con) {
+    const char sql[] = "SELECT id, value, name, payload FROM data;";
+    raw_statement raw(con.data(), sql);
+    s.run("decode_dynamic", "raw", db, table_rows, [&] {
+        sqlite3_reset(raw.ptr);
+        size_t bytes = 0;
+        while(sqlite3_step(raw.ptr) == SQLITE_ROW) {
+            for(int i = 0, n = sqlite3_column_count(raw.ptr); i < n; ++i) {
+                switch(sqlite3_column_type(raw.ptr, i)) {
+                case SQLITE_INTEGER:
+                    bytes += static_cast<size_t>(sqlite3_column_int64(raw.ptr, i)) & 1;
+                    break;
+                case SQLITE_FLOAT:
+                    bytes += sqlite3_column_double(raw.ptr, i) > 0;
+                    break;
+                case SQLITE_TEXT:
+                    sqlite3_column_text(raw.ptr, i);
+                    bytes += static_cast<size_t>(sqlite3_column_bytes(raw.ptr, i));
+                    break;
+                case SQLITE_BLOB:
+                    sqlite3_column_blob(raw.ptr, i);
+                    bytes += static_cast<size_t>(sqlite3_column_bytes(raw.ptr, i));
+                    break;
+                }
+            }
+        }
+        return bytes;
+    });
+
+    auto stmt = con.prepare(sql);
+    s.run("decode_dynamic", "dynamic_row", db, table_rows, [&] {
+        size_t bytes = 0;
+        for(auto&& row : stmt.fetch<sqlite::dynamic_row>()) {
+            for(auto&& v : row) {
+                bytes += v.size();
+            }
+        }
+        return bytes;
+    });
+}
+
+void transactions(bench::suite& s, bench::storage db, const sqlite::connection& con) {
+    const int n = 100;
+    auto insert = con.prepare("INSERT INTO sink(value, name) VALUES (1.0, 'x');");
+    s.run("transaction", "raw", db, n, [&] {
+        for(int i = 0; i < n; ++i) {
+            sqlite3_exec(con.data(), "BEGIN;", nullptr, nullptr, nullptr);
+            insert.execute();
+            sqlite3_exec(con.data(), "COMMIT;", nullptr, nullptr, nullptr);
+        }
+    });
+
+    s.run("transaction", "transaction", db, n, [&] {
+        for(int i = 0; i < n; ++i) {
+            auto tx = con.transaction();
+            insert.execute();
+            tx.commit();
+        }
+    });
+
+    s.run("transaction", "savepoint", db, n, [&] {
+        for(int i = 0; i < n; ++i) {
+            auto sp = con.savepoint();
+            insert.execute();
+            sp.commit();
+        }
+    });
+}
+
+void limits(bench::suite& s, bench::storage db, const sqlite::connection& con) {
+    auto stmt = con.prepare("SELECT id, value, name, payload FROM data;");
+    auto scan = [&] {
+        int rows = 0;
+        for(auto&& row : stmt.fetch<>()) {
+            (void)row;
+            ++rows;
+        }
+        return rows;
+    };
+
+    s.run("limits", "fetch", db, table_rows, scan);
+
+    for(int interval : { 10000, 1000, 100 }) {
+        sqlite::query_limits opts;
+        opts.deadline = sqlite::query_limits::clock::now() + std::chrono::hours(1);
+        opts.check_interval = interval;
+        s.run("limits", "interval_" + std::to_string(interval), db, table_rows, [&] {
+            return con.with_limits(opts, scan);
+        });
+    }
+}
+
+void scripts(bench::suite& s, bench::storage db, const sqlite::connection& con) {
+    const int n = 8;
+    const char sql[] = "CREATE TEMP TABLE scratch(id INTEGER PRIMARY KEY, name TEXT);"
+                       "INSERT INTO scratch(name) VALUES ('a');"
+                       "INSERT INTO scratch(name) VALUES ('b');"
+                       "INSERT INTO scratch(name) VALUES ('c');"
+                       "UPDATE scratch SET name = name || '!' WHERE id = 2;"
+                       "DELETE FROM scratch WHERE id = 1;"
+                       "CREATE INDEX temp.scratch_name ON scratch(name);"
+                       "DROP TABLE scratch;";
+    s.run("script", "raw", db, n, [&] {
+        sqlite3_exec(con.data(), sql, nullptr, nullptr, nullptr);
+    });
+
+    s.run("script", "execute", db, n, [&] {
+        con.execute(sql);
+    });
+
+    s.run("script", "execute_script", db, n, [&] {
+        con.execute_script(sql);
+    });
+}
+
+void bulk(bench::suite& s, bench::storage db, const sqlite::connection& con) {
+    using row_type = std::tuple<double, std::string>;
+    const int n = 10000;
+    std::vector<row_type> rows;
+    for(int i = 0; i < n; ++i) {
+        rows.emplace_back(i * 0.5, "name " + std::to_string(i));
+    }
+
+    raw_statement raw(con.data(), "INSERT INTO sink(value, name) VALUES (?, ?);");
+    s.run("bulk_insert", "raw", db, n, [&] {
+        sqlite3_exec(con.data(), "BEGIN;", nullptr, nullptr, nullptr);
+        for(auto&& row : rows) {
+            sqlite3_bind_double(raw.ptr, 1, std::get<0>(row));
+            auto&& name = std::get<1>(row);
+            sqlite3_bind_text(raw.ptr, 2, name.c_str(), static_cast<int>(name.size()), SQLITE_TRANSIENT);
+            sqlite3_step(raw.ptr);
+            sqlite3_reset(raw.ptr);
+        }
+        sqlite3_exec(con.data(), "COMMIT;", nullptr, nullptr, nullptr);
+    });
+
+    auto stmt = con.prepare("INSERT INTO sink(value, name) VALUES (?, ?);");
+    s.run("bulk_insert", "execute", db, n, [&] {
+        auto tx = con.transaction();
+        for(auto&& row : rows) {
+            stmt.execute(std::get<0>(row), std::get<1>(row));
+        }
+        tx.commit();
+    });
+
+    sqlite::bulk_writer single(con, "sink", { "value", "name" });
+    s.run("bulk_insert", "bulk_writer", db, n, [&] {
+        single.write(rows);
+    });
+
+    sqlite::bulk_options opts;
+    opts.multi_row = true;
+    sqlite::bulk_writer multi(con, "sink", { "value", "name" }, opts);
+    s.run("bulk_insert", "bulk_writer_multi", db, n, [&] {
+        multi.write(rows);
+    });
+}
+
+long long decode_int64(sqlite3_stmt* ptr) {
+    return sqlite3_column_int64(ptr, 0);
+}
+
+double decode_double(sqlite3_stmt* ptr) {
+    return sqlite3_column_double(ptr, 0);
+}
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    bench::suite s(argc, argv);
+    for(auto db : { bench::storage::memory, bench::storage::wal }) {
+        auto con = bench::open(db);
+        populate(con);
+        prepare(s, db, con);
+        bind(s, db, con);
+        step(s, db, con);
+        point_query(s, db, con);
+        decode<long long>(s, db, con, "decode_int64", "id", decode_int64);
+        decode<double>(s, db, con, "decode_double", "value", decode_double);
+        decode_text(s, db, con);
+        decode_dynamic(s, db, con);
+        transactions(s, db, con);
+        limits(s, db, con);
+        scripts(s, db, con);
+        bulk(s, db, con);
+    }
+    bench::remove_database("sqlitexx_bench.db");
+    return s.report();
+}
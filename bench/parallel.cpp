@@ -0,0 +1,71 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// Full table aggregation through parallel_scan with an increasing number of shards.
+// The optional argument is the row count, the speedup needs more than one core.
+
+#include "bench.hpp"
+
+#include <sqlitexx/parallel.hpp>
+
+#include <string>
+#include <thread>
+
+int main(int argc, char** argv) {
+    bench::suite s(argc, argv);
+    size_t rows = s.arguments().empty() ? 1000000 : std::stoul(s.arguments()[0]);
+    const char filename[] = "sqlitexx_bench.db";
+    bench::remove_database(filename);
+
+    sqlite::pool_options opts;
+    opts.readers = std::max(4u, std::thread::hardware_concurrency());
+    sqlite::connection_pool pool(filename, opts);
+    {
+        auto writer = pool.write();
+        writer->execute("CREATE TABLE data(id INTEGER PRIMARY KEY, name TEXT, score REAL);");
+        auto tx = writer->transaction();
+        auto stmt = writer->prepare("INSERT INTO data(id, name, score) VALUES (?, ?, ?);");
+        for(size_t i = 0; i < rows; ++i) {
+            stmt.execute(static_cast<long long>(i), "row number " + std::to_string(i), i * 0.25);
+        }
+        tx.commit();
+    }
+
+    const char query[] = "SELECT score, length(name) FROM data WHERE id >= :lo AND id < :hi;";
+    volatile double sink = 0;
+    for(size_t shards = 1; shards <= opts.readers; shards *= 2) {
+        sqlite::scan_options scan_opts;
+        scan_opts.shards = shards;
+        sqlite::parallel_scan scan(pool, "data", "id", scan_opts);
+        s.run("aggregate", "shards_" + std::to_string(shards), bench::storage::wal, rows, [&] {
+            sink = sink + scan.reduce<double, long long>(query, 0.0, [](double& acc, auto&& row) {
+                acc += row.template get<0>() + row.template get<1>();
+            }, [](double& result, double partial) {
+                result += partial;
+            });
+        });
+    }
+
+    bench::remove_database(filename);
+    return s.report();
+}
@@ -0,0 +1,83 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// Scans a table while the consumer does some work per row, comparing the plain fetch
+// with fetch_pipelined where stepping and decoding happen on a second thread.
+// The optional argument is the row count, the speedup needs more than one core.
+
+#include "bench.hpp"
+
+#include <string>
+#include <tuple>
+
+namespace {
+// stands in for application work on each row
+size_t work(const std::string& text, int rounds) noexcept {
+    size_t hash = 14695981039346656037ull;
+    for(int i = 0; i < rounds; ++i) {
+        for(char c : text) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+void run(bench::suite& s, bench::storage db, size_t rows) {
+    auto con = bench::open(db);
+    con.execute("CREATE TABLE data(id INTEGER PRIMARY KEY, name TEXT, score REAL);");
+    {
+        auto tx = con.transaction();
+        auto stmt = con.prepare("INSERT INTO data(id, name, score) VALUES (?, ?, ?);");
+        for(size_t i = 0; i < rows; ++i) {
+            stmt.execute(static_cast<long long>(i), "row number " + std::to_string(i), i * 0.25);
+        }
+        tx.commit();
+    }
+
+    auto stmt = con.prepare("SELECT id, name, score FROM data;");
+    volatile size_t sink = 0;
+    for(int rounds : { 0, 4, 16 }) {
+        auto group = "scan_work" + std::to_string(rounds);
+        s.run(group, "fetch", db, rows, [&] {
+            for(auto&& row : stmt.fetch<long long, std::string, double>()) {
+                sink = sink + work(row.get<1>(), rounds) + static_cast<size_t>(row.get<0>());
+            }
+        });
+
+        s.run(group, "fetch_pipelined", db, rows, [&] {
+            for(auto&& row : stmt.fetch_pipelined<long long, std::string, double>()) {
+                sink = sink + work(std::get<1>(row), rounds) + static_cast<size_t>(std::get<0>(row));
+            }
+        });
+    }
+}
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    bench::suite s(argc, argv);
+    size_t rows = s.arguments().empty() ? 100000 : std::stoul(s.arguments()[0]);
+    run(s, bench::storage::memory, rows);
+    run(s, bench::storage::wal, rows);
+    bench::remove_database("sqlitexx_bench.db");
+    return s.report();
+}
@@ -0,0 +1,96 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// Cold start of a read-mostly reference database: copying its rows into an in-memory database
+// versus deserializing a copy of the file versus deserializing the mapped file in place.
+// Every case runs one full scan afterwards so the pages are actually read.
+// The optional argument is the row count.
+
+#include "bench.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+long long scan(const sqlite::connection& con) {
+    long long total = 0;
+    for(auto&& row : con.fetch<long long>("SELECT sum(length(name)) FROM data;")) {
+        total = row.get<0>();
+    }
+    return total;
+}
+
+sqlite::connection open_memory() {
+    return { ":memory:", sqlite::connection::read_write | sqlite::connection::create };
+}
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    bench::suite s(argc, argv);
+    size_t rows = s.arguments().empty() ? 100000 : std::stoul(s.arguments()[0]);
+    const char filename[] = "sqlitexx_bench.db";
+    {
+        auto con = bench::open(bench::storage::wal, filename);
+        con.execute("CREATE TABLE data(id INTEGER PRIMARY KEY, name TEXT, score REAL);");
+        auto tx = con.transaction();
+        auto stmt = con.prepare("INSERT INTO data(id, name, score) VALUES (?, ?, ?);");
+        for(size_t i = 0; i < rows; ++i) {
+            stmt.execute(static_cast<long long>(i), "row number " + std::to_string(i), i * 0.25);
+        }
+        tx.commit();
+        con.execute("PRAGMA wal_checkpoint(TRUNCATE);");
+    }
+
+    s.run("load", "copy_rows", bench::storage::wal, rows, [&] {
+        auto con = open_memory();
+        con.execute("ATTACH DATABASE 'sqlitexx_bench.db' AS source;"
+                    "CREATE TABLE data(id INTEGER PRIMARY KEY, name TEXT, score REAL);"
+                    "INSERT INTO data SELECT * FROM source.data;"
+                    "DETACH DATABASE source;");
+        return scan(con);
+    });
+
+#if SQLITEXX_HAS_SERIALIZE
+    s.run("load", "deserialize", bench::storage::wal, rows, [&] {
+        std::ifstream file(filename, std::ios::binary);
+        std::vector<char> image{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+        auto con = open_memory();
+        con.deserialize(image.data(), image.size());
+        return scan(con);
+    });
+
+#if SQLITEXX_HAS_MMAP
+    s.run("load", "deserialize_view", bench::storage::wal, rows, [&] {
+        sqlite::mapped_file file(filename);
+        auto con = open_memory();
+        con.deserialize_view(file);
+        return scan(con);
+    });
+#endif
+#endif
+
+    bench::remove_database(filename);
+    return s.report();
+}
@@ -0,0 +1,99 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// Compares decoding rows into a mapped struct against hand written sqlite3_column_* calls.
+// usage: bench_struct_mapping [rows] [--json] [--min-time=S] [--filter=TEXT]
+
+#include "bench.hpp"
+
+#include <string>
+#include <tuple>
+
+namespace {
+struct person {
+    long long id;
+    std::string name;
+    double score;
+};
+} // anonymous namespace
+
+namespace sqlite {
+template<>
+struct row_mapping<person> {
+    static constexpr auto fields() {
+        return std::make_tuple(field("id", &person::id), field("name", &person::name), field("score", &person::score));
+    }
+};
+} // sqlite
+
+namespace {
+void run(bench::suite& s, bench::storage db, size_t rows) {
+    auto con = bench::open(db);
+    con.execute("CREATE TABLE people(id INTEGER PRIMARY KEY, name TEXT, score REAL);");
+    {
+        auto tx = con.transaction();
+        auto stmt = con.prepare("INSERT INTO people(id, name, score) VALUES (?, ?, ?);");
+        for(size_t i = 0; i < rows; ++i) {
+            stmt.execute(static_cast<long long>(i), "person " + std::to_string(i), i * 0.25);
+        }
+        tx.commit();
+    }
+
+    auto stmt = con.prepare("SELECT id, name, score FROM people;");
+    volatile double sink = 0;
+
+    s.run("struct_decode", "raw", db, rows, [&] {
+        auto ptr = stmt.data();
+        sqlite3_reset(ptr);
+        person p;
+        while(sqlite3_step(ptr) == SQLITE_ROW) {
+            p.id = sqlite3_column_int64(ptr, 0);
+            auto text = reinterpret_cast<const char*>(sqlite3_column_text(ptr, 1));
+            p.name.assign(text, static_cast<size_t>(sqlite3_column_bytes(ptr, 1)));
+            p.score = sqlite3_column_double(ptr, 2);
+            sink = sink + p.id + p.name.size() + p.score;
+        }
+    });
+
+    s.run("struct_decode", "column_get", db, rows, [&] {
+        for(auto&& row : stmt.fetch<long long, std::string, double>()) {
+            sink = sink + row.get<0>() + row.get<1>().size() + row.get<2>();
+        }
+    });
+
+    s.run("struct_decode", "fetch_struct", db, rows, [&] {
+        for(auto&& p : stmt.fetch<person>()) {
+            sink = sink + p.id + p.name.size() + p.score;
+        }
+    });
+}
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    bench::suite s(argc, argv);
+    size_t rows = s.arguments().empty() ? 100000 : std::stoul(s.arguments()[0]);
+    run(s, bench::storage::memory, rows);
+    run(s, bench::storage::wal, rows);
+    bench::remove_database("sqlitexx_bench.db");
+    return s.report();
+}
@@ -0,0 +1,139 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// Cost of routing file I/O through io_stats_vfs compared to the default VFS, with and without
+// write coalescing and read-ahead. Inserts commit every 100 rows, scans use a fresh connection
+// with a tiny page cache so every page goes through the VFS. After each shim is timed, one
+// untimed run of the same workload prints its I/O counters to stderr.
+
+#include "bench.hpp"
+
+#include <sqlitexx/vfs.hpp>
+
+#include <cstdio>
+#include <string>
+
+namespace {
+const int rows = 20000;
+const char filename[] = "sqlitexx_bench.db";
+
+void load(const char* vfs) {
+    bench::remove_database(filename);
+    sqlite::connection con(filename, sqlite::connection::read_write | sqlite::connection::create, vfs);
+    con.execute("PRAGMA journal_mode = WAL; PRAGMA synchronous = OFF;"
+                "CREATE TABLE data(id INTEGER PRIMARY KEY, name TEXT);");
+    auto stmt = con.prepare("INSERT INTO data(name) VALUES (?);");
+    for(int i = 0; i < rows; i += 100) {
+        auto tx = con.transaction();
+        for(int j = i; j < i + 100; ++j) {
+            stmt.execute("row number " + std::to_string(j));
+        }
+        tx.commit();
+    }
+}
+
+long long read_all(const char* vfs) {
+    sqlite::connection con(filename, sqlite::connection::read_write, vfs);
+    con.execute("PRAGMA cache_size = 8;");
+    long long total = 0;
+    for(auto&& row : con.fetch<long long>("SELECT sum(length(name)) FROM data;")) {
+        total = row.get<0>();
+    }
+    return total;
+}
+
+const char* file_kind(int type) noexcept {
+    switch(type) {
+    case SQLITE_OPEN_MAIN_DB:
+        return "db";
+    case SQLITE_OPEN_WAL:
+        return "wal";
+    case SQLITE_OPEN_MAIN_JOURNAL:
+        return "journal";
+    default:
+        return "temp";
+    }
+}
+
+// the counters of a single run of work, on stderr so --json output stays parseable
+template<typename F>
+void print_io(const char* group, const char* name, sqlite::io_stats_vfs& vfs, F&& work) {
+    vfs.reset();
+    work();
+    for(auto&& file : vfs.snapshot()) {
+        if(file.opens == 0) {
+            continue;
+        }
+        std::fprintf(stderr, "  io %-6s %-20s %-7s reads %6llu (%llu from read-ahead)  writes %6llu (%llu coalesced)  syncs %llu\n",
+                     group, name, file_kind(file.type), static_cast<unsigned long long>(file.reads.calls),
+                     static_cast<unsigned long long>(file.readahead_hits), static_cast<unsigned long long>(file.writes.calls),
+                     static_cast<unsigned long long>(file.coalesced_writes), static_cast<unsigned long long>(file.syncs.calls));
+    }
+}
+
+void insert(bench::suite& s, const char* name, sqlite::io_stats_vfs* vfs) {
+    const char* vfs_name = vfs ? vfs->name() : nullptr;
+    s.run("insert", name, bench::storage::wal, rows, [&] {
+        load(vfs_name);
+    });
+    if(vfs && s.enabled("insert", name)) {
+        print_io("insert", name, *vfs, [&] { load(vfs_name); });
+    }
+}
+
+void scan(bench::suite& s, const char* name, sqlite::io_stats_vfs* vfs) {
+    const char* vfs_name = vfs ? vfs->name() : nullptr;
+    s.run("scan", name, bench::storage::wal, rows, [&] {
+        return read_all(vfs_name);
+    });
+    if(vfs && s.enabled("scan", name)) {
+        print_io("scan", name, *vfs, [&] { read_all(vfs_name); });
+    }
+}
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    bench::suite s(argc, argv);
+    sqlite::io_stats_vfs counting("bench_io_stats");
+    sqlite::io_stats_options opts;
+    opts.coalesce_bytes = 64 * 1024;
+    opts.readahead_bytes = 64 * 1024;
+    sqlite::io_stats_vfs tuned("bench_io_tuned", opts);
+
+    insert(s, "default", nullptr);
+    insert(s, "io_stats", &counting);
+    insert(s, "io_stats_coalesce", &tuned);
+
+    {
+        // leave a checkpointed database behind for the scans
+        sqlite::connection con(filename, sqlite::connection::read_write);
+        con.execute("PRAGMA wal_checkpoint(TRUNCATE);");
+    }
+
+    scan(s, "default", nullptr);
+    scan(s, "io_stats", &counting);
+    scan(s, "io_stats_readahead", &tuned);
+
+    bench::remove_database(filename);
+    return s.report();
+}
@@ -0,0 +1,373 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <sqlitexx/connection.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <sqlite3.h>
+
+namespace sqlite {
+struct write_options {
+    // most jobs committed in a single transaction
+    size_t max_batch = 256;
+
+    // how long a batch may wait for more jobs after its first one arrives
+    std::chrono::microseconds max_latency{0};
+
+    // called on the writer thread before any job runs, if it throws every job fails with its exception
+    std::function<void(connection&)> setup;
+};
+
+struct write_stats {
+    size_t jobs;
+    size_t failed_jobs;
+    size_t batches;
+    size_t largest_batch;
+};
+
+namespace detail {
+struct write_job {
+    write_job* next = nullptr;
+    bool failed = false;
+
+    virtual ~write_job() = default;
+    virtual void run(connection& con) = 0;
+    virtual void complete() noexcept = 0;
+    virtual void fail(std::exception_ptr ex) noexcept = 0;
+};
+
+template<typename F>
+using write_result_t = decltype(std::declval<F&>()(std::declval<connection&>()));
+
+template<typename R>
+struct write_result {
+    template<typename F>
+    void run(F& f, connection& con) {
+        ::new(static_cast<void*>(storage)) R(f(con));
+        engaged = true;
+    }
+
+    void complete(std::promise<R>& promise) noexcept {
+        promise.set_value(std::move(*reinterpret_cast<R*>(storage)));
+    }
+
+    ~write_result() {
+        if(engaged) {
+            reinterpret_cast<R*>(storage)->~R();
+        }
+    }
+private:
+    alignas(R) unsigned char storage[sizeof(R)];
+    bool engaged = false;
+};
+
+template<>
+struct write_result<void> {
+    template<typename F>
+    void run(F& f, connection& con) {
+        f(con);
+    }
+
+    void complete(std::promise<void>& promise) noexcept {
+        promise.set_value();
+    }
+};
+
+template<typename F, typename R>
+struct write_task : write_job {
+    template<typename Fn>
+    write_task(Fn&& f): f(std::forward<Fn>(f)) {}
+
+    void run(connection& con) override {
+        result.run(f, con);
+    }
+
+    void complete() noexcept override {
+        result.complete(promise);
+    }
+
+    void fail(std::exception_ptr ex) noexcept override {
+        failed = true;
+        promise.set_exception(std::move(ex));
+    }
+
+    F f;
+    std::promise<R> promise;
+    write_result<R> result;
+};
+} // detail
+
+// Owns a writer connection on a dedicated thread and runs submitted jobs on it.
+// Whatever jobs have queued up are committed together in one transaction (group commit),
+// each inside its own savepoint so a job that throws only rolls back its own changes.
+// The futures are only made ready once the batch's transaction commits.
+struct write_executor {
+    template<typename String>
+    explicit write_executor(const String& filename, write_options opts = {}):
+        write_executor(connection(filename, connection::read_write | connection::create | connection::uri | connection::no_mutex), std::move(opts)) {}
+
+    explicit write_executor(connection con, write_options opts = {}): con(std::move(con)), opts(std::move(opts)) {
+        worker = std::thread([this] { loop(); });
+    }
+
+    write_executor(const write_executor&) = delete;
+    write_executor& operator=(const write_executor&) = delete;
+
+    // finishes every queued job before returning
+    ~write_executor() {
+        stopping = true;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            wakeup.notify_one();
+        }
+        worker.join();
+    }
+
+    template<typename F, typename R = detail::write_result_t<std::decay_t<F>>>
+    std::future<R> submit(F&& f) {
+        auto task = new detail::write_task<std::decay_t<F>, R>(std::forward<F>(f));
+        auto future = task->promise.get_future();
+        push(task);
+        return future;
+    }
+
+    write_stats stats() const noexcept {
+        return {
+            jobs.load(std::memory_order_relaxed),
+            failed_jobs.load(std::memory_order_relaxed),
+            batches.load(std::memory_order_relaxed),
+            largest_batch.load(std::memory_order_relaxed)
+        };
+    }
+private:
+    void push(detail::write_job* job) noexcept {
+        job->next = head.load(std::memory_order_relaxed);
+        while(!head.compare_exchange_weak(job->next, job)) {}
+
+        if(sleeping.load()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            wakeup.notify_one();
+        }
+    }
+
+    struct job_list {
+        detail::write_job* first = nullptr;
+        detail::write_job* last = nullptr;
+        size_t size = 0;
+    };
+
+    // moves everything queued so far onto the end of the list in submission order
+    void take(job_list& list) noexcept {
+        detail::write_job* stack = head.exchange(nullptr);
+        detail::write_job* reversed = nullptr;
+        detail::write_job* tail = stack;
+        while(stack) {
+            auto next = stack->next;
+            stack->next = reversed;
+            reversed = stack;
+            stack = next;
+            ++list.size;
+        }
+
+        if(reversed) {
+            if(list.last) {
+                list.last->next = reversed;
+            }
+            else {
+                list.first = reversed;
+            }
+            list.last = tail;
+        }
+    }
+
+    // removes up to count jobs from the front of the list
+    static job_list split(job_list& list, size_t count) noexcept {
+        job_list result;
+        result.first = list.first;
+        for(auto job = list.first; job && result.size < count; job = job->next) {
+            result.last = job;
+            ++result.size;
+        }
+
+        list.first = result.last->next;
+        list.size -= result.size;
+        if(list.first == nullptr) {
+            list.last = nullptr;
+        }
+        result.last->next = nullptr;
+        return result;
+    }
+
+    template<typename Predicate>
+    void sleep(Predicate&& ready) {
+        std::unique_lock<std::mutex> lock(mutex);
+        sleeping = true;
+        wakeup.wait(lock, ready);
+        sleeping = false;
+    }
+
+    template<typename Predicate>
+    void sleep_until(std::chrono::steady_clock::time_point deadline, Predicate&& ready) {
+        std::unique_lock<std::mutex> lock(mutex);
+        sleeping = true;
+        wakeup.wait_until(lock, deadline, ready);
+        sleeping = false;
+    }
+
+    void loop() {
+        // a connection that couldn't be set up fails the jobs instead of taking the process down
+        std::exception_ptr broken;
+        if(opts.setup) {
+            try {
+                opts.setup(con);
+            }
+            catch(...) {
+                broken = std::current_exception();
+            }
+        }
+
+        auto has_work = [this] { return head.load() != nullptr || stopping.load(); };
+        size_t max_batch = std::max<size_t>(1, opts.max_batch);
+        job_list queue;
+        for(;;) {
+            if(queue.size == 0) {
+                sleep(has_work);
+                take(queue);
+                if(queue.size == 0) {
+                    // only happens once we're stopping and everything has been drained
+                    return;
+                }
+
+                if(opts.max_latency.count() > 0) {
+                    auto deadline = std::chrono::steady_clock::now() + opts.max_latency;
+                    while(queue.size < max_batch && !stopping.load() && std::chrono::steady_clock::now() < deadline) {
+                        sleep_until(deadline, has_work);
+                        take(queue);
+                    }
+                }
+            }
+
+            auto batch = split(queue, max_batch);
+            run_batch(batch.first, batch.size, broken);
+
+            // whatever arrived during the commit has already waited long enough
+            take(queue);
+        }
+    }
+
+    // runs every job of the batch in one transaction, returns what made the whole batch fail if anything did
+    std::exception_ptr commit_batch(detail::write_job* batch) noexcept {
+        std::exception_ptr failure;
+        try {
+            auto tx = con.transaction(transaction::immediate);
+            try {
+                for(auto job = batch; job; job = job->next) {
+                    auto sp = con.savepoint();
+                    try {
+                        job->run(con);
+                    }
+                    catch(...) {
+                        job->fail(std::current_exception());
+                    }
+
+                    // outside the handler so a failing rollback fails the whole batch instead of
+                    // escaping while the job's exception is still being handled
+                    if(job->failed) {
+                        sp.rollback();
+                        continue;
+                    }
+                    sp.commit();
+                }
+                tx.commit();
+            }
+            catch(...) {
+                failure = std::current_exception();
+                tx.rollback();
+            }
+        }
+        catch(...) {
+            if(!failure) {
+                failure = std::current_exception();
+            }
+        }
+        return failure;
+    }
+
+    void run_batch(detail::write_job* batch, size_t count, std::exception_ptr failure) noexcept {
+        // the failure is already set when the connection couldn't be set up
+        if(!failure) {
+            failure = commit_batch(batch);
+        }
+
+        size_t failures = 0;
+        while(batch) {
+            auto next = batch->next;
+            if(!batch->failed && failure) {
+                batch->fail(failure);
+            }
+            else if(!batch->failed) {
+                batch->complete();
+            }
+
+            failures += batch->failed;
+            delete batch;
+            batch = next;
+        }
+
+        jobs.fetch_add(count, std::memory_order_relaxed);
+        failed_jobs.fetch_add(failures, std::memory_order_relaxed);
+        batches.fetch_add(1, std::memory_order_relaxed);
+        if(count > largest_batch.load(std::memory_order_relaxed)) {
+            largest_batch.store(count, std::memory_order_relaxed);
+        }
+    }
+
+    connection con;
+    write_options opts;
+    std::atomic<detail::write_job*> head{nullptr};
+    std::atomic<bool> sleeping{false};
+    std::atomic<bool> stopping{false};
+    std::mutex mutex;
+    std::condition_variable wakeup;
+
+    std::atomic<size_t> jobs{0};
+    std::atomic<size_t> failed_jobs{0};
+    std::atomic<size_t> batches{0};
+    std::atomic<size_t> largest_batch{0};
+
+    std::thread worker;
+};
+} // sqlite
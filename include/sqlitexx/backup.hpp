@@ -0,0 +1,166 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <sqlitexx/type_traits.hpp>
+#include <sqlitexx/error.hpp>
+#include <sqlitexx/connection.hpp>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <sqlite3.h>
+
+namespace sqlite {
+struct backup_options {
+    // pages copied per step, the source is only locked while a step runs
+    int pages_per_step = 256;
+
+    // how long to sleep between steps so writers on the source can get in
+    std::chrono::milliseconds pause{0};
+
+    // how long to back off when the source or destination is busy
+    std::chrono::milliseconds busy_pause{10};
+
+    // run throws the SQLITE_BUSY or SQLITE_LOCKED error once the databases have stayed busy this
+    // long without a step getting through, 0 keeps retrying forever
+    std::chrono::milliseconds max_busy_wait{30000};
+
+    // called after every step with the remaining and total page counts, return false to stop early
+    std::function<bool(int, int)> progress;
+};
+
+// An online copy of a database from one connection to another through sqlite3_backup.
+// Copying a live database into a file takes a hot snapshot, copying a file into an
+// in-memory connection loads it. Both connections must outlive the backup.
+struct backup {
+    backup(const connection& destination, const connection& source): backup(destination, "main", source, "main") {}
+
+    template<typename DestinationName, typename SourceName>
+    backup(const connection& destination, const DestinationName& destination_name,
+           const connection& source, const SourceName& source_name) {
+        auto ptr = sqlite3_backup_init(destination.data(), meta::string_traits<DestinationName>::c_str(destination_name),
+                                       source.data(), meta::string_traits<SourceName>::c_str(source_name));
+        if(ptr == nullptr) {
+            throw error(sqlite3_extended_errcode(destination.data()));
+        }
+        handle.reset(ptr);
+    }
+
+    // copies up to the given number of pages (-1 for all of them), returns true once the copy is complete.
+    // a busy or locked database is not an error, the step can simply be retried later.
+    bool step(int pages) {
+        int ret = sqlite3_backup_step(handle.get(), pages);
+        switch(ret) {
+        case SQLITE_DONE:
+            return true;
+        case SQLITE_OK:
+        case SQLITE_BUSY:
+        case SQLITE_LOCKED:
+            return false;
+        default:
+            throw error(ret);
+        }
+    }
+
+    // steps until completion according to the options, returns false if the progress callback stopped it
+    bool run(const backup_options& opts = {}) {
+        using clock = std::chrono::steady_clock;
+        bool busy = false;
+        clock::time_point busy_since;
+        for(;;) {
+            int ret = sqlite3_backup_step(handle.get(), opts.pages_per_step);
+            if(ret == SQLITE_DONE) {
+                report(opts);
+                return true;
+            }
+
+            if(ret == SQLITE_BUSY || ret == SQLITE_LOCKED) {
+                auto now = clock::now();
+                if(!busy) {
+                    busy = true;
+                    busy_since = now;
+                }
+                if(opts.max_busy_wait.count() > 0 && now - busy_since >= opts.max_busy_wait) {
+                    throw error(ret);
+                }
+                std::this_thread::sleep_for(opts.busy_pause);
+                continue;
+            }
+            busy = false;
+
+            if(ret != SQLITE_OK) {
+                throw error(ret);
+            }
+
+            if(!report(opts)) {
+                return false;
+            }
+
+            if(opts.pause.count() > 0) {
+                std::this_thread::sleep_for(opts.pause);
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // only meaningful after the first step
+    int remaining() const noexcept {
+        return sqlite3_backup_remaining(handle.get());
+    }
+
+    int page_count() const noexcept {
+        return sqlite3_backup_pagecount(handle.get());
+    }
+
+    // fraction of the pages copied so far
+    double progress() const noexcept {
+        int total = page_count();
+        return total == 0 ? 0.0 : static_cast<double>(total - remaining()) / total;
+    }
+
+    // releases the backup, reporting any error that happened during it
+    void finish() {
+        int ret = sqlite3_backup_finish(handle.release());
+        if(ret != SQLITE_OK) {
+            throw error(ret);
+        }
+    }
+private:
+    bool report(const backup_options& opts) const {
+        return !opts.progress || opts.progress(remaining(), page_count());
+    }
+
+    struct deleter {
+        void operator()(sqlite3_backup* ptr) const noexcept {
+            sqlite3_backup_finish(ptr);
+        }
+    };
+
+    std::unique_ptr<sqlite3_backup, deleter> handle;
+};
+} // sqlite
@@ -0,0 +1,248 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <sqlitexx/type_traits.hpp>
+#include <sqlitexx/error.hpp>
+#include <sqlitexx/statement.hpp>
+
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <sqlite3.h>
+
+namespace sqlite {
+namespace detail {
+// variable length values packed back to back with an offset table, offsets.size() == size() + 1
+template<typename Byte>
+struct arena_column {
+    size_t size() const noexcept {
+        return offsets.size() - 1;
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    size_t size(size_t row) const noexcept {
+        return offsets[row + 1] - offsets[row];
+    }
+
+    const Byte* data(size_t row) const noexcept {
+        return bytes.data() + offsets[row];
+    }
+
+    // the raw storage for every row, suitable for tight loops
+    const std::vector<Byte>& buffer() const noexcept {
+        return bytes;
+    }
+
+    const std::vector<size_t>& offset_table() const noexcept {
+        return offsets;
+    }
+
+    void clear() noexcept {
+        bytes.clear();
+        offsets.resize(1);
+    }
+
+    void reserve(size_t rows) {
+        offsets.reserve(rows + 1);
+    }
+
+    void push_back(const void* ptr, size_t length) {
+        auto first = static_cast<const Byte*>(ptr);
+        bytes.insert(bytes.end(), first, first + length);
+        offsets.push_back(bytes.size());
+    }
+protected:
+    std::vector<Byte> bytes;
+    std::vector<size_t> offsets = std::vector<size_t>(1, 0);
+};
+} // detail
+
+struct text_column : detail::arena_column<char> {
+#if SQLITEXX_HAS_STRING_VIEW
+    std::string_view operator[](size_t row) const noexcept {
+        return { data(row), size(row) };
+    }
+#endif
+};
+
+struct blob_column : detail::arena_column<unsigned char> {
+    blob operator[](size_t row) const noexcept {
+        return { data(row), static_cast<int>(size(row)) };
+    }
+};
+
+namespace meta {
+// maps a requested column type to the contiguous buffer it's decoded into
+template<typename T, typename = void>
+struct batch_traits {
+    static_assert(dependent_false<T>::value, "Unsupported batch column type.");
+};
+
+template<typename T>
+struct batch_traits<T, std::enable_if_t<(is_integer<T>::value && !std::is_same<T, bool>::value) || std::is_floating_point<T>::value>> {
+    using type = std::vector<T>;
+
+    static void append(type& column, sqlite3_stmt* ptr, int index) {
+        column.push_back(column_traits<T>::convert(ptr, index));
+    }
+};
+
+// std::vector<bool> is packed and has no data(), so booleans are stored one byte each as 0 or 1
+template<>
+struct batch_traits<bool> {
+    using type = std::vector<unsigned char>;
+
+    static void append(type& column, sqlite3_stmt* ptr, int index) {
+        column.push_back(sqlite3_column_int(ptr, index) != 0);
+    }
+};
+
+template<typename... Rest>
+struct batch_traits<std::basic_string<char, Rest...>> {
+    using type = text_column;
+
+    static void append(type& column, sqlite3_stmt* ptr, int index) {
+        auto str = sqlite3_column_text(ptr, index);
+        column.push_back(str, static_cast<size_t>(sqlite3_column_bytes(ptr, index)));
+    }
+};
+
+#if SQLITEXX_HAS_STRING_VIEW
+template<typename Traits>
+struct batch_traits<std::basic_string_view<char, Traits>> : batch_traits<std::string> {};
+#endif
+
+template<>
+struct batch_traits<blob> {
+    using type = blob_column;
+
+    static void append(type& column, sqlite3_stmt* ptr, int index) {
+        auto data = sqlite3_column_blob(ptr, index);
+        column.push_back(data, static_cast<size_t>(sqlite3_column_bytes(ptr, index)));
+    }
+};
+} // meta
+
+// A set of rows decoded into one contiguous buffer per column (struct of arrays).
+// Clearing a batch keeps its capacity so it can be reused across fetches without reallocating.
+// There's no null indicator: a NULL decodes to 0 in numeric columns and to an empty value in
+// text and blob columns, so use IFNULL or a separate column where the difference matters.
+template<typename... Args>
+struct column_batch {
+    template<size_t N>
+    const auto& column() const noexcept {
+        static_assert(N < sizeof...(Args), "Out of bounds");
+        return std::get<N>(columns);
+    }
+
+    size_t size() const noexcept {
+        return rows;
+    }
+
+    bool empty() const noexcept {
+        return rows == 0;
+    }
+
+    void clear() noexcept {
+        clear_impl(std::index_sequence_for<Args...>{});
+        rows = 0;
+    }
+
+    void reserve(size_t n) {
+        reserve_impl(n, std::index_sequence_for<Args...>{});
+    }
+
+    // decodes the current row of the statement onto the end of the batch
+    void append(sqlite3_stmt* ptr) {
+        append_impl(ptr, std::index_sequence_for<Args...>{});
+        ++rows;
+    }
+private:
+    template<size_t... I>
+    void clear_impl(std::index_sequence<I...>) noexcept {
+        using dummy = int[];
+        (void)dummy{ 0, (std::get<I>(columns).clear(), 0)... };
+    }
+
+    template<size_t... I>
+    void reserve_impl(size_t n, std::index_sequence<I...>) {
+        using dummy = int[];
+        (void)dummy{ 0, (std::get<I>(columns).reserve(n), 0)... };
+    }
+
+    template<size_t... I>
+    void append_impl(sqlite3_stmt* ptr, std::index_sequence<I...>) {
+        using dummy = int[];
+        (void)dummy{ 0, (meta::batch_traits<meta::unqualified_t<Args>>::append(std::get<I>(columns), ptr, static_cast<int>(I)), 0)... };
+    }
+
+    std::tuple<typename meta::batch_traits<meta::unqualified_t<Args>>::type...> columns;
+    size_t rows = 0;
+};
+
+namespace detail {
+template<typename Pointer, typename... Args>
+struct batch_reader {
+    using batch_type = column_batch<Args...>;
+
+    Pointer _ptr;
+    size_t rows_per_batch;
+    int ret = SQLITE_OK;
+
+    // steps up to rows_per_batch rows into the batch, returns false once there are no more rows
+    bool next(batch_type& batch) {
+        batch.clear();
+        if(ret == SQLITE_OK) {
+            reset();
+            batch.reserve(rows_per_batch);
+        }
+
+        while(ret != SQLITE_DONE && batch.size() < rows_per_batch) {
+            ret = sqlite3_step(_ptr.get());
+            if(ret == SQLITE_ROW) {
+                batch.append(_ptr.get());
+            }
+            else if(ret != SQLITE_DONE) {
+                throw error(ret);
+            }
+        }
+        return !batch.empty();
+    }
+
+    void reset() {
+        int code = sqlite3_reset(_ptr.get());
+        if(code != SQLITE_OK) {
+            throw error(code);
+        }
+        ret = SQLITE_ROW;
+    }
+};
+} // detail
+} // sqlite
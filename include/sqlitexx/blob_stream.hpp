@@ -0,0 +1,141 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <sqlitexx/type_traits.hpp>
+#include <sqlitexx/error.hpp>
+#include <sqlitexx/connection.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <sqlite3.h>
+
+namespace sqlite {
+// Incremental I/O over a single blob through sqlite3_blob_open so large values
+// can be read or written in chunks without materializing the whole thing.
+// A blob can't change size through a stream, preallocate it with zeroblob first.
+struct blob_stream {
+    enum open_mode : int {
+        read_only  = 0,
+        read_write = 1
+    };
+
+    blob_stream() noexcept = default;
+
+    template<typename Table, typename Column>
+    blob_stream(const connection& con, const Table& table, const Column& column, sqlite3_int64 rowid, int flags = read_only) {
+        open(con, "main", table, column, rowid, flags);
+    }
+
+    template<typename Database, typename Table, typename Column>
+    void open(const connection& con, const Database& database, const Table& table, const Column& column,
+              sqlite3_int64 rowid, int flags = read_only) {
+        sqlite3_blob* ptr = nullptr;
+        int ret = sqlite3_blob_open(con.data(),
+                                    meta::string_traits<Database>::c_str(database),
+                                    meta::string_traits<Table>::c_str(table),
+                                    meta::string_traits<Column>::c_str(column),
+                                    rowid, flags, &ptr);
+        if(ret != SQLITE_OK) {
+            // the handle is allocated even on failure
+            sqlite3_blob_close(ptr);
+            throw error(ret);
+        }
+
+        handle.reset(ptr);
+        position = 0;
+    }
+
+    // moves the stream onto the same column of another row, much cheaper than opening a new one
+    void reopen(sqlite3_int64 rowid) {
+        int ret = sqlite3_blob_reopen(handle.get(), rowid);
+        if(ret != SQLITE_OK) {
+            throw error(ret);
+        }
+        position = 0;
+    }
+
+    void close() noexcept {
+        handle.reset();
+    }
+
+    bool is_open() const noexcept {
+        return handle != nullptr;
+    }
+
+    sqlite3_blob* data() const noexcept {
+        return handle.get();
+    }
+
+    size_t size() const noexcept {
+        return static_cast<size_t>(sqlite3_blob_bytes(handle.get()));
+    }
+
+    size_t tell() const noexcept {
+        return position;
+    }
+
+    void seek(size_t offset) {
+        if(offset > size()) {
+            throw error(SQLITE_RANGE);
+        }
+        position = offset;
+    }
+
+    // reads up to count bytes from the current position, returning how many were read
+    size_t read(void* buffer, size_t count) {
+        count = std::min(count, size() - position);
+        if(count != 0) {
+            int ret = sqlite3_blob_read(handle.get(), buffer, static_cast<int>(count), static_cast<int>(position));
+            if(ret != SQLITE_OK) {
+                throw error(ret);
+            }
+            position += count;
+        }
+        return count;
+    }
+
+    // writes count bytes at the current position, which must fit within the blob
+    void write(const void* buffer, size_t count) {
+        if(count > size() - position) {
+            throw error(SQLITE_RANGE);
+        }
+
+        int ret = sqlite3_blob_write(handle.get(), buffer, static_cast<int>(count), static_cast<int>(position));
+        if(ret != SQLITE_OK) {
+            throw error(ret);
+        }
+        position += count;
+    }
+private:
+    struct deleter {
+        void operator()(sqlite3_blob* ptr) const noexcept {
+            sqlite3_blob_close(ptr);
+        }
+    };
+
+    std::unique_ptr<sqlite3_blob, deleter> handle;
+    size_t position = 0;
+};
+} // sqlite
@@ -0,0 +1,232 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <sqlitexx/connection.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <sqlite3.h>
+
+namespace sqlite {
+struct bulk_options {
+    // number of rows written before the current transaction is committed and a new one begins
+    size_t rows_per_transaction = 10000;
+
+    // generates INSERT ... VALUES (...),(...) statements holding as many rows
+    // as SQLITE_LIMIT_VARIABLE_NUMBER allows, capped by max_rows_per_statement if non-zero.
+    // very large statements end up slower than moderately sized ones, hence the default cap.
+    bool multi_row = false;
+    size_t max_rows_per_statement = 500;
+
+    // the verb used, e.g. "INSERT OR REPLACE"
+    std::string insert = "INSERT";
+
+    // appended after the VALUES list, e.g. "ON CONFLICT(id) DO UPDATE SET value = excluded.value"
+    std::string upsert;
+
+    // the database the table is in, e.g. the name of an attached one, empty for the usual lookup
+    std::string schema;
+};
+
+// Writes ranges of rows into a table through one reused prepared statement. The table and column
+// names are quoted when the statement is built so they're given as is, without quotes.
+// Rows are tuple-like (std::tuple, std::pair, std::array), mapped structs (see row_mapping)
+// or anything a projection turns into one of those.
+// If the connection is already inside a transaction then no transactions are opened.
+struct bulk_writer {
+    template<typename String>
+    bulk_writer(const connection& con, const String& table, std::vector<std::string> columns, bulk_options opts = {}):
+        con(con), table(meta::string_traits<String>::data(table), meta::string_traits<String>::size(table)), columns(std::move(columns)), opts(std::move(opts)) {
+        if(this->columns.empty()) {
+            throw error(SQLITE_MISUSE);
+        }
+
+        rows_per_statement = 1;
+        if(this->opts.multi_row) {
+            size_t limit = static_cast<size_t>(sqlite3_limit(con.data(), SQLITE_LIMIT_VARIABLE_NUMBER, -1));
+            rows_per_statement = std::max<size_t>(1, limit / this->columns.size());
+            if(this->opts.max_rows_per_statement != 0) {
+                rows_per_statement = std::min(rows_per_statement, this->opts.max_rows_per_statement);
+            }
+        }
+    }
+
+    template<typename Range>
+    size_t write(const Range& rows) {
+        return write(rows, identity{});
+    }
+
+    template<typename Range, typename Projection>
+    size_t write(const Range& rows, Projection&& proj) {
+        using std::begin;
+        using std::end;
+        auto first = begin(rows);
+        auto last = end(rows);
+        size_t remaining = static_cast<size_t>(std::distance(first, last));
+        size_t total = remaining;
+
+        // the caller's transaction takes precedence over ours
+        bool owns_transaction = sqlite3_get_autocommit(con.data()) != 0;
+        // keep transaction boundaries on whole statements
+        size_t per_transaction = opts.rows_per_transaction == 0 ? remaining : opts.rows_per_transaction;
+        per_transaction = std::max(per_transaction - per_transaction % rows_per_statement, rows_per_statement);
+        while(remaining != 0) {
+            size_t chunk = std::min(remaining, per_transaction);
+            if(owns_transaction) {
+                auto tx = con.transaction(transaction::immediate);
+                first = write_chunk(first, chunk, proj);
+                tx.commit();
+            }
+            else {
+                first = write_chunk(first, chunk, proj);
+            }
+            remaining -= chunk;
+        }
+        return total;
+    }
+
+    size_t statement_rows() const noexcept {
+        return rows_per_statement;
+    }
+private:
+    // mapped structs are written field by field, anything else has to be tuple-like already
+    struct identity {
+        template<typename T, std::enable_if_t<!meta::is_mapped<T>::value, int> = 0>
+        const T& operator()(const T& value) const noexcept {
+            return value;
+        }
+
+        template<typename T, std::enable_if_t<meta::is_mapped<T>::value, int> = 0>
+        auto operator()(const T& value) const noexcept {
+            return meta::tie_fields(value);
+        }
+    };
+
+    template<typename Iterator, typename Projection>
+    Iterator write_chunk(Iterator it, size_t count, Projection& proj) {
+        if(rows_per_statement > 1 && count >= rows_per_statement) {
+            auto&& stmt = get(batch, rows_per_statement);
+            for(; count >= rows_per_statement; count -= rows_per_statement) {
+                for(size_t row = 0; row < rows_per_statement; ++row, ++it) {
+                    bind_row(stmt, static_cast<int>(row * columns.size()), proj(*it));
+                }
+                execute(stmt);
+            }
+        }
+
+        if(count != 0) {
+            auto&& stmt = get(single, 1);
+            for(; count != 0; --count, ++it) {
+                bind_row(stmt, 0, proj(*it));
+                execute(stmt);
+            }
+        }
+
+        return it;
+    }
+
+    // a failed step leaves the statement halted and every later bind on it fails with SQLITE_MISUSE
+    static void execute(const statement& stmt) {
+        try {
+            stmt.execute();
+        }
+        catch(...) {
+            sqlite3_reset(stmt.data());
+            throw;
+        }
+    }
+
+    template<typename Row>
+    void bind_row(const statement& stmt, int offset, const Row& row) const {
+        using tuple_size = std::tuple_size<meta::unqualified_t<Row>>;
+        if(tuple_size::value != columns.size()) {
+            throw error(SQLITE_RANGE);
+        }
+        bind_row(stmt, offset, row, std::make_index_sequence<tuple_size::value>{});
+    }
+
+    template<typename Row, size_t... I>
+    void bind_row(const statement& stmt, int offset, const Row& row, std::index_sequence<I...>) const {
+        using std::get;
+        using dummy = int[];
+        (void)dummy{ 0, (stmt.bind_to(offset + static_cast<int>(I + 1), get<I>(row)), 0)... };
+    }
+
+    statement& get(std::unique_ptr<statement>& stmt, size_t rows) {
+        if(!stmt) {
+            stmt = std::make_unique<statement>(con.prepare(make_query(rows)));
+        }
+        return *stmt;
+    }
+
+    std::string make_query(size_t rows) const {
+        std::string placeholders = "(?";
+        for(size_t i = 1; i < columns.size(); ++i) {
+            placeholders += ",?";
+        }
+        placeholders += ')';
+
+        std::string query = opts.insert + " INTO ";
+        if(!opts.schema.empty()) {
+            query += detail::quote_identifier(opts.schema) + '.';
+        }
+        query += detail::quote_identifier(table) + '(';
+        for(size_t i = 0; i < columns.size(); ++i) {
+            if(i != 0) {
+                query += ',';
+            }
+            query += detail::quote_identifier(columns[i]);
+        }
+        query += ") VALUES ";
+        query.reserve(query.size() + rows * (placeholders.size() + 1) + opts.upsert.size() + 2);
+        for(size_t i = 0; i < rows; ++i) {
+            if(i != 0) {
+                query += ',';
+            }
+            query += placeholders;
+        }
+
+        if(!opts.upsert.empty()) {
+            query += ' ';
+            query += opts.upsert;
+        }
+        query += ';';
+        return query;
+    }
+
+    const connection& con;
+    std::string table;
+    std::vector<std::string> columns;
+    bulk_options opts;
+    size_t rows_per_statement;
+    std::unique_ptr<statement> batch;
+    std::unique_ptr<statement> single;
+};
+} // sqlite
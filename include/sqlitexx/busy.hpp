@@ -0,0 +1,221 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <sqlitexx/error.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sqlite3.h>
+
+namespace sqlite {
+// How long to keep retrying when a lock is held by another connection.
+// Each retry sleeps for a random duration in [delay * (1 - jitter), delay] where delay
+// starts at initial_delay and grows by multiplier after every retry up to max_delay.
+struct busy_policy {
+    std::chrono::microseconds initial_delay{100};
+    std::chrono::microseconds max_delay{20000};
+    double multiplier = 2.0;
+    double jitter = 0.5;
+
+    // the statement fails with SQLITE_BUSY once it has waited this long in total
+    std::chrono::milliseconds max_wait{5000};
+
+    // hands the waiting over to sqlite3_busy_timeout(max_wait) instead, which
+    // is cheaper but collects no statistics
+    bool use_busy_timeout = false;
+};
+
+struct statement_contention {
+    std::string sql;
+    uint64_t events = 0;
+    uint64_t timeouts = 0;
+    std::chrono::nanoseconds wait_time{0};
+};
+
+struct busy_stats {
+    // number of times a lock was found busy, not counting the retries
+    uint64_t events = 0;
+    uint64_t retries = 0;
+    // number of times max_wait ran out and SQLITE_BUSY was returned
+    uint64_t timeouts = 0;
+    std::chrono::nanoseconds wait_time{0};
+    std::chrono::nanoseconds max_wait_time{0};
+    std::vector<statement_contention> statements;
+};
+
+// Retries busy locks through sqlite3_busy_handler according to a busy_policy and keeps count.
+// Contention is charged to the statement on the connection that's running and writes, or to
+// any running statement when none of them write.
+struct busy_handler {
+    busy_handler(sqlite3* db, const busy_policy& policy): db(db), policy(policy), rng(std::random_device{}()) {
+        int ret = policy.use_busy_timeout ? sqlite3_busy_timeout(db, static_cast<int>(policy.max_wait.count()))
+                                          : sqlite3_busy_handler(db, &busy_handler::callback, this);
+        if(ret != SQLITE_OK) {
+            throw error(ret);
+        }
+    }
+
+    busy_handler(const busy_handler&) = delete;
+    busy_handler& operator=(const busy_handler&) = delete;
+
+    ~busy_handler() {
+        sqlite3_busy_handler(db, nullptr, nullptr);
+    }
+
+    busy_stats snapshot() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        busy_stats result = stats;
+        result.statements.reserve(statements.size());
+        for(auto&& entry : statements) {
+            result.statements.push_back(entry.second);
+        }
+        return result;
+    }
+
+    const busy_policy& policy_in_use() const noexcept {
+        return policy;
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats = busy_stats{};
+        statements.clear();
+    }
+private:
+    using clock = std::chrono::steady_clock;
+
+    static int callback(void* context, int count) noexcept {
+        try {
+            return static_cast<busy_handler*>(context)->retry(count);
+        }
+        catch(...) {
+            return 0;
+        }
+    }
+
+    int retry(int count) {
+        auto now = clock::now();
+        if(count == 0) {
+            episode_start = now;
+            delay = policy.initial_delay;
+            current = blame();
+        }
+
+        auto waited = now - episode_start;
+        auto pause = next_delay();
+        bool give_up = waited + pause > policy.max_wait;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto&& entry = find(current);
+            if(count == 0) {
+                ++stats.events;
+                ++entry.events;
+            }
+            else {
+                ++stats.retries;
+            }
+
+            if(give_up) {
+                ++stats.timeouts;
+                ++entry.timeouts;
+                if(waited > stats.max_wait_time) {
+                    stats.max_wait_time = std::chrono::duration_cast<std::chrono::nanoseconds>(waited);
+                }
+                return 0;
+            }
+        }
+
+        std::this_thread::sleep_for(pause);
+        auto slept = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - now);
+        auto total = std::chrono::duration_cast<std::chrono::nanoseconds>(waited) + slept;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.wait_time += slept;
+        find(current).wait_time += slept;
+        if(total > stats.max_wait_time) {
+            stats.max_wait_time = total;
+        }
+        return 1;
+    }
+
+    std::chrono::microseconds next_delay() {
+        auto upper = delay;
+        auto grown = std::chrono::duration<double, std::micro>(delay) * policy.multiplier;
+        delay = std::min(policy.max_delay, std::chrono::duration_cast<std::chrono::microseconds>(grown));
+
+        double jitter = std::min(1.0, std::max(0.0, policy.jitter));
+        std::uniform_real_distribution<double> dist(1.0 - jitter, 1.0);
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::duration<double, std::micro>(upper) * dist(rng));
+    }
+
+    const char* blame() const noexcept {
+        const char* fallback = nullptr;
+        for(auto stmt = sqlite3_next_stmt(db, nullptr); stmt != nullptr; stmt = sqlite3_next_stmt(db, stmt)) {
+            if(!sqlite3_stmt_busy(stmt)) {
+                continue;
+            }
+            if(!sqlite3_stmt_readonly(stmt)) {
+                return sqlite3_sql(stmt);
+            }
+            if(fallback == nullptr) {
+                fallback = sqlite3_sql(stmt);
+            }
+        }
+        return fallback;
+    }
+
+    statement_contention& find(const char* sql) {
+        std::string key = sql == nullptr ? std::string() : std::string(sql);
+        auto it = statements.find(key);
+        if(it == statements.end()) {
+            it = statements.emplace(key, statement_contention{}).first;
+            it->second.sql = key;
+        }
+        return it->second;
+    }
+
+    sqlite3* db;
+    busy_policy policy;
+    std::minstd_rand rng;
+
+    // state of the current wait, only touched from the thread stepping the statement
+    clock::time_point episode_start;
+    std::chrono::microseconds delay{0};
+    const char* current = nullptr;
+
+    mutable std::mutex mutex;
+    busy_stats stats;
+    std::unordered_map<std::string, statement_contention> statements;
+};
+} // sqlite
@@ -0,0 +1,212 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <sqlitexx/type_traits.hpp>
+#include <sqlitexx/statement.hpp>
+
+#include <cstring>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <sqlite3.h>
+
+namespace sqlite {
+namespace detail {
+// non-owning view over the SQL text so lookups don't have to allocate
+struct sql_key {
+    const char* data;
+    size_t size;
+
+    bool operator==(const sql_key& o) const noexcept {
+        return size == o.size && std::memcmp(data, o.data, size) == 0;
+    }
+};
+
+struct sql_key_hash {
+    size_t operator()(const sql_key& key) const noexcept {
+        // FNV-1a
+        size_t hash = static_cast<size_t>(14695981039346656037ULL);
+        for(size_t i = 0; i < key.size; ++i) {
+            hash ^= static_cast<unsigned char>(key.data[i]);
+            hash *= static_cast<size_t>(1099511628211ULL);
+        }
+        return hash;
+    }
+};
+} // detail
+
+// A size bounded LRU cache of prepared statements keyed by their SQL text.
+// Statements handed out by acquire are returned to the cache when they're destroyed,
+// at which point they're reset and have their bindings cleared. A statement that's still
+// checked out when the cache is destroyed is detached and finalizes itself instead.
+struct statement_cache {
+    struct stats_type {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+    };
+
+    explicit statement_cache(size_t capacity) noexcept: _capacity(capacity) {}
+
+    statement_cache(const statement_cache&) = delete;
+    statement_cache& operator=(const statement_cache&) = delete;
+
+    ~statement_cache() {
+        for(auto&& e : entries) {
+            if(e->in_use) {
+                e->cache = nullptr;
+                e.release();
+            }
+            else {
+                sqlite3_finalize(e->ptr);
+            }
+        }
+    }
+
+    template<typename String>
+    statement acquire(sqlite3* db, const String& sql) {
+        using Traits = meta::string_traits<String>;
+        detail::sql_key key{ Traits::data(sql), Traits::size(sql) };
+        auto it = lookup.find(key);
+        if(it != lookup.end() && sqlite3_db_handle((*it->second)->ptr) != db) {
+            // prepared on a different connection, which may not even be open anymore
+            if((*it->second)->in_use) {
+                ++counters.misses;
+                return { db, sql };
+            }
+            erase(it->second);
+            it = lookup.end();
+        }
+
+        if(it != lookup.end()) {
+            auto entry = it->second;
+            if(!(*entry)->in_use) {
+                ++counters.hits;
+                entries.splice(entries.begin(), entries, entry);
+                (*entry)->in_use = true;
+                return { (*entry)->ptr, entry->get() };
+            }
+
+            // already checked out so just hand out a one-off statement
+            ++counters.misses;
+            return { db, sql };
+        }
+
+        ++counters.misses;
+#if SQLITE_VERSION_NUMBER >= 3020000
+        auto ptr = detail::prepare(db, key.data, static_cast<int>(key.size), SQLITE_PREPARE_PERSISTENT);
+#else
+        auto ptr = detail::prepare(db, key.data, static_cast<int>(key.size), 0);
+#endif
+        try {
+            entries.push_front(std::make_unique<entry>(this, std::string(key.data, key.size), ptr));
+        }
+        catch(...) {
+            sqlite3_finalize(ptr);
+            throw;
+        }
+        auto&& e = *entries.front();
+        lookup.emplace(detail::sql_key{ e.sql.data(), e.sql.size() }, entries.begin());
+        trim();
+        return { ptr, &e };
+    }
+
+    // finalizes every statement that isn't currently checked out
+    void clear() noexcept {
+        for(auto it = entries.begin(); it != entries.end();) {
+            it = (*it)->in_use ? std::next(it) : erase(it);
+        }
+    }
+
+    // evicts the least recently used statements that no longer fit
+    void set_capacity(size_t capacity) noexcept {
+        _capacity = capacity;
+        trim();
+    }
+
+    stats_type stats() const noexcept {
+        return counters;
+    }
+
+    size_t size() const noexcept {
+        return entries.size();
+    }
+
+    size_t capacity() const noexcept {
+        return _capacity;
+    }
+private:
+    struct entry final : detail::statement_owner {
+        entry(statement_cache* cache, std::string sql, sqlite3_stmt* ptr) noexcept:
+            cache(cache), sql(std::move(sql)), ptr(ptr) {}
+
+        void release(sqlite3_stmt*) noexcept override {
+            if(cache == nullptr) {
+                // the cache went away while this was checked out
+                sqlite3_finalize(ptr);
+                delete this;
+                return;
+            }
+
+            sqlite3_reset(ptr);
+            sqlite3_clear_bindings(ptr);
+            in_use = false;
+            cache->trim();
+        }
+
+        statement_cache* cache;
+        std::string sql;
+        sqlite3_stmt* ptr;
+        bool in_use = true;
+    };
+
+    // entries are allocated on their own so a detached one can outlive the cache
+    using iterator = std::list<std::unique_ptr<entry>>::iterator;
+
+    iterator erase(iterator it) noexcept {
+        lookup.erase(detail::sql_key{ (*it)->sql.data(), (*it)->sql.size() });
+        sqlite3_finalize((*it)->ptr);
+        return entries.erase(it);
+    }
+
+    void trim() noexcept {
+        auto it = entries.end();
+        while(entries.size() > _capacity && it != entries.begin()) {
+            --it;
+            if(!(*it)->in_use) {
+                it = erase(it);
+                ++counters.evictions;
+            }
+        }
+    }
+
+    std::list<std::unique_ptr<entry>> entries;
+    std::unordered_map<detail::sql_key, iterator, detail::sql_key_hash> lookup;
+    stats_type counters;
+    size_t _capacity;
+};
+} // sqlite
@@ -25,31 +25,163 @@
 #include <sqlitexx/type_traits.hpp>
 #include <sqlitexx/error.hpp>
 #include <sqlitexx/statement.hpp>
+#include <sqlitexx/cache.hpp>
+#include <sqlitexx/batch.hpp>
+#include <sqlitexx/pipeline.hpp>
+#include <sqlitexx/dynamic.hpp>
+#include <sqlitexx/profiler.hpp>
+#include <sqlitexx/function.hpp>
+#include <sqlitexx/vtab.hpp>
+#include <sqlitexx/memory.hpp>
+#include <sqlitexx/script.hpp>
+#include <sqlitexx/typed_statement.hpp>
+#include <sqlitexx/interrupt.hpp>
+#include <sqlitexx/busy.hpp>
+#include <sqlitexx/serialize.hpp>
+#include <sqlitexx/vfs.hpp>
 
+#include <chrono>
 #include <memory>
+#include <string>
+#include <vector>
 #include <sqlite3.h>
 
 namespace sqlite {
+namespace detail {
+// The transaction control statements of a connection. These are prepared
+// the first time they're needed and then reused for the lifetime of the connection.
+struct transaction_control {
+    explicit transaction_control(sqlite3* db) noexcept: db(db) {}
+
+    transaction_control(const transaction_control&) = delete;
+    transaction_control& operator=(const transaction_control&) = delete;
+
+    ~transaction_control() {
+        for(auto ptr : begin_stmts) {
+            sqlite3_finalize(ptr);
+        }
+
+        sqlite3_finalize(commit_stmt);
+        sqlite3_finalize(rollback_stmt);
+
+        for(auto&& sp : savepoints) {
+            sqlite3_finalize(sp.save);
+            sqlite3_finalize(sp.release);
+            sqlite3_finalize(sp.rollback);
+        }
+    }
+
+    void begin(int mode) {
+        static const char* const queries[] = {
+            "BEGIN DEFERRED;",
+            "BEGIN IMMEDIATE;",
+            "BEGIN EXCLUSIVE;"
+        };
+        run(begin_stmts[mode], queries[mode]);
+    }
+
+    void commit() {
+        run(commit_stmt, "COMMIT;");
+    }
+
+    void rollback() {
+        run(rollback_stmt, "ROLLBACK;");
+    }
+
+    // returns the depth of the newly opened savepoint
+    size_t push_savepoint() {
+        if(savepoints.size() == depth) {
+            savepoints.emplace_back();
+        }
+
+        auto&& sp = savepoints[depth];
+        run(sp.save, "SAVEPOINT", depth + 1);
+        return ++depth;
+    }
+
+    void release_savepoint(size_t level) {
+        run(savepoints[level - 1].release, "RELEASE", level);
+        depth = level - 1;
+    }
+
+    void rollback_savepoint(size_t level) {
+        // ROLLBACK TO leaves the savepoint on the stack so it has to be released afterwards
+        run(savepoints[level - 1].rollback, "ROLLBACK TO", level);
+        release_savepoint(level);
+    }
+
+    sqlite3* handle() const noexcept {
+        return db;
+    }
+private:
+    struct savepoint_statements {
+        sqlite3_stmt* save = nullptr;
+        sqlite3_stmt* release = nullptr;
+        sqlite3_stmt* rollback = nullptr;
+    };
+
+    sqlite3_stmt* prepare_persistent(const char* query) const {
+#if SQLITE_VERSION_NUMBER >= 3020000
+        return prepare(db, query, -1, SQLITE_PREPARE_PERSISTENT);
+#else
+        return prepare(db, query, -1, 0);
+#endif
+    }
+
+    void step(sqlite3_stmt* ptr) const {
+        int ret = sqlite3_step(ptr);
+        sqlite3_reset(ptr);
+        if(ret != SQLITE_DONE) {
+            throw error(ret);
+        }
+    }
+
+    void run(sqlite3_stmt*& ptr, const char* query) {
+        if(ptr == nullptr) {
+            ptr = prepare_persistent(query);
+        }
+        step(ptr);
+    }
+
+    void run(sqlite3_stmt*& ptr, const char* command, size_t level) {
+        if(ptr == nullptr) {
+            auto query = std::string(command) + " sqlitexx_savepoint_" + std::to_string(level) + ';';
+            ptr = prepare_persistent(query.c_str());
+        }
+        step(ptr);
+    }
+
+    sqlite3* db;
+    sqlite3_stmt* begin_stmts[3] = {};
+    sqlite3_stmt* commit_stmt = nullptr;
+    sqlite3_stmt* rollback_stmt = nullptr;
+    std::vector<savepoint_statements> savepoints;
+    size_t depth = 0;
+};
+} // detail
+
 struct transaction {
+    enum mode : int {
+        deferred,
+        immediate,
+        exclusive
+    };
+
     template<typename Connection>
-    transaction(const Connection& con): _commit(con.prepare("COMMIT;")), _rollback(con.prepare("ROLLBACK;")) {
-        con.execute("BEGIN TRANSACTION;");
+    transaction(const Connection& con, mode m = deferred): control(&con.control_statements()) {
+        control->begin(m);
     }
 
     transaction(const transaction&) = delete;
     transaction& operator=(const transaction&) = delete;
 
-    transaction(transaction&& o) noexcept:
-        _commit(std::move(o._commit)),
-        _rollback(std::move(o._rollback)),
-        needs_rollback(o.needs_rollback) {
+    transaction(transaction&& o) noexcept: control(o.control), needs_rollback(o.needs_rollback) {
         o.needs_rollback = false;
     }
 
     transaction& operator=(transaction&& o) noexcept {
         needs_rollback = o.needs_rollback;
-        _commit = std::move(o._commit);
-        _rollback = std::move(o._rollback);
+        control = o.control;
         o.needs_rollback = false;
         return *this;
     }
@@ -62,20 +194,68 @@ struct transaction {
 
     void commit() {
         if(needs_rollback) {
-            _commit.execute();
+            control->commit();
             needs_rollback = false;
         }
     }
 
+    // a failed rollback isn't attempted again by the destructor
     void rollback() {
         if(needs_rollback) {
-            _rollback.execute();
             needs_rollback = false;
+            control->rollback();
         }
     }
 private:
-    statement _commit;
-    statement _rollback;
+    detail::transaction_control* control;
+    bool needs_rollback = true;
+};
+
+// A nestable RAII savepoint. Savepoints must be released in the reverse order they were opened.
+// If there's no transaction active then the outermost savepoint starts one.
+struct savepoint {
+    template<typename Connection>
+    savepoint(const Connection& con): control(&con.control_statements()) {
+        level = control->push_savepoint();
+    }
+
+    savepoint(const savepoint&) = delete;
+    savepoint& operator=(const savepoint&) = delete;
+    savepoint& operator=(savepoint&&) = delete;
+
+    savepoint(savepoint&& o) noexcept: control(o.control), level(o.level), needs_rollback(o.needs_rollback) {
+        o.needs_rollback = false;
+    }
+
+    ~savepoint() noexcept(false) {
+        if(needs_rollback) {
+            rollback();
+        }
+    }
+
+    // releases the savepoint, folding its changes into the enclosing transaction or savepoint
+    void commit() {
+        if(needs_rollback) {
+            control->release_savepoint(level);
+            needs_rollback = false;
+        }
+    }
+
+    // undoes every change made since the savepoint was opened and then releases it,
+    // a failed rollback isn't attempted again by the destructor
+    void rollback() {
+        if(needs_rollback) {
+            needs_rollback = false;
+            control->rollback_savepoint(level);
+        }
+    }
+
+    size_t depth() const noexcept {
+        return level;
+    }
+private:
+    detail::transaction_control* control;
+    size_t level;
     bool needs_rollback = true;
 };
 
@@ -94,21 +274,52 @@ struct connection {
 
     connection() noexcept = default;
 
+    // vfs is the name of a registered VFS such as a vfs_shim, null for the default one
     template<typename String>
-    connection(const String& filename, int flags = open_mode::read_write | open_mode::uri) {
-        open(filename, flags);
+    connection(const String& filename, int flags = open_mode::read_write | open_mode::uri, const char* vfs = nullptr) {
+        open(filename, flags, vfs);
     }
 
+    // Re-opening closes the previous database. Throws SQLITE_MISUSE if it's in the middle of
+    // a transaction, since its transaction and savepoint guards would be left behind.
     template<typename String>
-    void open(const String& filename, int flags = open_mode::read_write | open_mode::uri) {
+    void open(const String& filename, int flags = open_mode::read_write | open_mode::uri, const char* vfs = nullptr) {
+        if(db && !sqlite3_get_autocommit(db.get())) {
+            throw error(SQLITE_MISUSE);
+        }
+
         auto ptr = db.get();
-        int ret = sqlite3_open_v2(meta::string_traits<String>::c_str(filename), &ptr, flags, nullptr);
+        int ret = sqlite3_open_v2(meta::string_traits<String>::c_str(filename), &ptr, flags, vfs);
         if(ret != SQLITE_OK) {
+            // a handle is usually allocated even when opening fails
+            sqlite3_close_v2(ptr);
             throw error(ret);
         }
 
         sqlite3_extended_result_codes(ptr, 1);
+
+        // cached and control statements belong to the previous handle, and so do the hooks
+        // of the profiler and the busy policy which get installed again on the new one
+        bool cached = cache != nullptr;
+        size_t cache_capacity = cached ? cache->capacity() : 0;
+        bool profiled = prof != nullptr;
+        unsigned profile_flags = profiled ? prof->flags_in_use() : profiler::none;
+        bool waits = busy != nullptr;
+        busy_policy policy = waits ? busy->policy_in_use() : busy_policy{};
+        cache.reset();
+        control.reset();
+        prof.reset();
+        busy.reset();
         db.reset(ptr);
+        if(cached) {
+            cache = std::make_unique<statement_cache>(cache_capacity);
+        }
+        if(profiled) {
+            prof = std::make_unique<profiler>(ptr, profile_flags);
+        }
+        if(waits) {
+            busy = std::make_unique<busy_handler>(ptr, policy);
+        }
     }
 
     sqlite3* data() const noexcept {
@@ -128,6 +339,83 @@ struct connection {
         sqlite3_db_release_memory(db.get());
     }
 
+    // Gives this connection its own lookaside allocator for small allocations. Has to be called
+    // before the connection allocates anything from it, otherwise it throws SQLITE_BUSY.
+    // A slot count of 0 disables lookaside for the connection.
+    void set_lookaside(int slot_size, int slots) {
+        int ret = sqlite3_db_config(db.get(), SQLITE_DBCONFIG_LOOKASIDE, nullptr, slot_size, slots);
+        if(ret != SQLITE_OK) {
+            throw error(ret);
+        }
+    }
+
+    // the highwater marks and lookaside hit/miss counters are reset afterwards when reset is true
+    memory_stats memory_usage(bool reset = false) const noexcept {
+        memory_stats stats;
+        int unused = 0;
+        int flag = reset;
+        sqlite3_db_status(db.get(), SQLITE_DBSTATUS_LOOKASIDE_USED, &stats.lookaside_used, &stats.lookaside_highwater, flag);
+        sqlite3_db_status(db.get(), SQLITE_DBSTATUS_LOOKASIDE_HIT, &unused, &stats.lookaside_hits, flag);
+        sqlite3_db_status(db.get(), SQLITE_DBSTATUS_LOOKASIDE_MISS_SIZE, &unused, &stats.lookaside_misses_size, flag);
+        sqlite3_db_status(db.get(), SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL, &unused, &stats.lookaside_misses_full, flag);
+        sqlite3_db_status(db.get(), SQLITE_DBSTATUS_CACHE_USED, &stats.cache_used, &unused, 0);
+        sqlite3_db_status(db.get(), SQLITE_DBSTATUS_SCHEMA_USED, &stats.schema_used, &unused, 0);
+        sqlite3_db_status(db.get(), SQLITE_DBSTATUS_STMT_USED, &stats.statement_used, &unused, 0);
+        return stats;
+    }
+
+#if SQLITEXX_HAS_SERIALIZE
+    // Copies a database out in its on-disk format, schema is "main" or the name of an attached database.
+    // An empty database gives back an empty image.
+    template<typename String = const char*>
+    serialized_database serialize(const String& schema = "main") const {
+        sqlite3_int64 size = 0;
+        auto ptr = sqlite3_serialize(db.get(), meta::string_traits<String>::c_str(schema), &size, 0);
+        if(ptr == nullptr && size != 0) {
+            throw error(size < 0 ? SQLITE_ERROR : SQLITE_NOMEM);
+        }
+        return { ptr, static_cast<size_t>(size) };
+    }
+
+    // Replaces schema with the database in image. The connection takes over the buffer without
+    // copying it and the database stays writable.
+    template<typename String = const char*>
+    void deserialize(serialized_database image, const String& schema = "main") {
+        size_t size = image.size();
+        detail::deserialize(db.get(), meta::string_traits<String>::c_str(schema), image.release(), size, size,
+                            SQLITE_DESERIALIZE_FREEONCLOSE | SQLITE_DESERIALIZE_RESIZEABLE);
+    }
+
+    // same as above but copies the size bytes at data first, so they can go away afterwards
+    template<typename String = const char*>
+    void deserialize(const void* data, size_t size, const String& schema = "main") {
+        auto copy = static_cast<unsigned char*>(sqlite3_malloc64(size == 0 ? 1 : size));
+        if(copy == nullptr) {
+            throw error(SQLITE_NOMEM);
+        }
+        std::memcpy(copy, data, size);
+        detail::deserialize(db.get(), meta::string_traits<String>::c_str(schema), copy, size, size,
+                            SQLITE_DESERIALIZE_FREEONCLOSE | SQLITE_DESERIALIZE_RESIZEABLE);
+    }
+
+    // Uses the size bytes at data as a read-only database without copying them. Nothing is freed and
+    // the memory has to stay valid and unchanged for as long as the connection uses it. The header of
+    // a WAL database image is switched back to rollback mode in place, which is why data isn't const.
+    template<typename String = const char*>
+    void deserialize_view(unsigned char* data, size_t size, const String& schema = "main") {
+        detail::deserialize(db.get(), meta::string_traits<String>::c_str(schema), data, size, size, SQLITE_DESERIALIZE_READONLY);
+    }
+
+#if SQLITEXX_HAS_MMAP
+    // e.g. sqlite::mapped_file file("reference.db"); con.deserialize_view(file);
+    // the file has to outlive the connection
+    template<typename String = const char*>
+    void deserialize_view(const mapped_file& file, const String& schema = "main") {
+        deserialize_view(file.data(), file.size(), schema);
+    }
+#endif
+#endif
+
     template<typename String>
     void execute(const String& query) const {
         detail::error_string error_msg;
@@ -137,33 +425,306 @@ struct connection {
         }
     }
 
+    // Runs every statement in query one at a time without going through sqlite3_exec.
+    // Named parameters are bound to each statement that refers to them. Failures throw
+    // script_error which says where in the script the error happened.
+    template<typename String, typename... Binding>
+    void execute_script(const String& query, const Binding&... binds) const {
+        ::sqlite::script(db.get(), query).run_all(binds...);
+    }
+
+    // Same as execute_script except the last statement isn't run, its rows are returned
+    // the same way as fetch. Throws SQLITE_MISUSE if the script has no statements.
+    template<typename... Args, typename String, typename... Binding>
+    auto fetch_script(const String& query, const Binding&... binds) const {
+        ::sqlite::script s(db.get(), query);
+        while(s.next()) {
+            s.bind_available(binds...);
+            if(s.is_last()) {
+                return std::move(s.current()).template fetch<Args...>();
+            }
+            s.run();
+        }
+        throw error(SQLITE_MISUSE);
+    }
+
+    // steps through the statements of query manually, see script
+    template<typename String>
+    ::sqlite::script script(const String& query) const noexcept {
+        return { db.get(), query };
+    }
+
+    // the script only references the query so it can't be a temporary
+    template<typename... Rest>
+    ::sqlite::script script(std::basic_string<char, Rest...>&&) const = delete;
+
     template<typename String>
     statement prepare(const String& sql) const {
         return { db.get(), sql };
     }
 
+    // e.g. auto stmt = con.prepare_typed<params(long long), row(std::string)>("SELECT name FROM t WHERE id = ?");
+    template<typename Params, typename Row, typename String>
+    typed_statement<Params, Row> prepare_typed(const String& sql) const {
+        return typed_statement<Params, Row>(prepare(sql));
+    }
+
+    // goes through the statement cache if it's enabled, otherwise the same as prepare
+    template<typename String>
+    statement prepare_cached(const String& sql) const {
+        if(cache) {
+            return cache->acquire(db.get(), sql);
+        }
+        return prepare(sql);
+    }
+
+    // calling this again only changes the capacity, the cached statements are kept
+    void enable_statement_cache(size_t capacity = 64) {
+        if(cache) {
+            cache->set_capacity(capacity);
+        }
+        else {
+            cache = std::make_unique<statement_cache>(capacity);
+        }
+    }
+
+    // statements still checked out from the cache are finalized once they're destroyed
+    void disable_statement_cache() noexcept {
+        cache.reset();
+    }
+
+    bool has_statement_cache() const noexcept {
+        return cache != nullptr;
+    }
+
+    statement_cache::stats_type cache_stats() const noexcept {
+        return cache ? cache->stats() : statement_cache::stats_type{};
+    }
+
+    // registers a trace callback, see profiler for the available flags
+    void enable_profiling(unsigned flags = profiler::none) {
+        prof.reset();
+        prof = std::make_unique<profiler>(db.get(), flags);
+    }
+
+    void disable_profiling() noexcept {
+        prof.reset();
+    }
+
+    bool is_profiling() const noexcept {
+        return prof != nullptr;
+    }
+
+    std::vector<statement_profile> profile_snapshot() const {
+        return prof ? prof->snapshot() : std::vector<statement_profile>{};
+    }
+
+    void reset_profile() {
+        if(prof) {
+            prof->reset();
+        }
+    }
+
+    // Waits out locks held by other connections according to policy instead of failing with
+    // SQLITE_BUSY straight away. Replaces any previous policy and resets the statistics.
+    void set_busy_policy(const busy_policy& policy) {
+        busy.reset();
+        busy = std::make_unique<busy_handler>(db.get(), policy);
+    }
+
+    // back to failing with SQLITE_BUSY immediately
+    void clear_busy_policy() noexcept {
+        busy.reset();
+    }
+
+    bool has_busy_policy() const noexcept {
+        return busy != nullptr;
+    }
+
+    busy_stats busy_snapshot() const {
+        return busy ? busy->snapshot() : busy_stats{};
+    }
+
+    void reset_busy_stats() {
+        if(busy) {
+            busy->reset();
+        }
+    }
+
+    // Registers f as a scalar SQL function. The argument and result types are deduced from f,
+    // see meta::value_traits and meta::result_traits. Exceptions thrown from f become SQL errors.
+    template<typename String, typename F>
+    void create_function(const String& name, F f, int flags = function_flags::none) {
+        detail::create_function(db.get(), meta::string_traits<String>::c_str(name), std::move(f), flags);
+    }
+
+    // Registers an aggregate SQL function. Each group works on a copy of prototype, which must have
+    // a step member function taking the arguments and a final member function returning the result.
+    template<typename String, typename Aggregate>
+    void create_aggregate(const String& name, Aggregate prototype, int flags = function_flags::none) {
+        detail::create_aggregate(db.get(), meta::string_traits<String>::c_str(name), std::move(prototype), flags);
+    }
+
+    template<typename Aggregate, typename String>
+    void create_aggregate(const String& name, int flags = function_flags::none) {
+        create_aggregate(name, Aggregate{}, flags);
+    }
+
+#if SQLITE_VERSION_NUMBER >= 3025000
+    // Same as create_aggregate but the aggregate can also be used as a window function. Aside from
+    // step and final it needs an inverse member function that removes a row from the window
+    // and a value member function that returns the current result without finishing.
+    template<typename String, typename Aggregate>
+    void create_window_function(const String& name, Aggregate prototype, int flags = function_flags::none) {
+        detail::create_window_function(db.get(), meta::string_traits<String>::c_str(name), std::move(prototype), flags);
+    }
+
+    template<typename Aggregate, typename String>
+    void create_window_function(const String& name, int flags = function_flags::none) {
+        create_window_function(name, Aggregate{}, flags);
+    }
+#endif
+
+    // Exposes a random access range of mapped structs (see row_mapping) as a read-only table
+    // that can be queried directly by name. The range is referenced rather than copied, so it has
+    // to outlive the connection and must not change while registered. Columns named in keys get a
+    // sorted index of row positions so equality and range constraints on them are binary searches.
+    template<typename String, typename Range>
+    void create_range_table(const String& name, const Range& range, const std::vector<std::string>& keys = {}) {
+        detail::create_range_table(db.get(), meta::string_traits<String>::c_str(name), range, keys);
+    }
+
+    template<typename String, typename Range>
+    void create_range_table(const String&, const Range&&, const std::vector<std::string>& = {}) = delete;
+
     template<typename... Args, typename String, typename... Binding>
     auto fetch(const String& query, Binding&&... binds) const {
-        auto stmt = prepare(query);
+        auto stmt = prepare_cached(query);
         stmt.bind(std::forward<Binding>(binds)...);
         return std::move(stmt).template fetch<Args...>();
     }
 
     template<typename... Args, typename String>
     auto fetch(const String& query) const {
-        return prepare(query).template fetch<Args...>();
+        return prepare_cached(query).template fetch<Args...>();
+    }
+
+    template<typename... Args, typename String, typename... Binding>
+    auto fetch_batches(const String& query, size_t rows_per_batch, Binding&&... binds) const {
+        auto stmt = prepare_cached(query);
+        stmt.bind(std::forward<Binding>(binds)...);
+        return std::move(stmt).template fetch_batches<Args...>(rows_per_batch);
+    }
+
+    template<typename... Args, typename String>
+    auto fetch_batches(const String& query, size_t rows_per_batch) const {
+        return prepare_cached(query).template fetch_batches<Args...>(rows_per_batch);
     }
 
-    transaction transaction() const {
+    template<typename... Args, typename String, typename... Binding>
+    auto fetch_pipelined(const String& query, size_t capacity, Binding&&... binds) const {
+        auto stmt = prepare_cached(query);
+        stmt.bind(std::forward<Binding>(binds)...);
+        return std::move(stmt).template fetch_pipelined<Args...>(capacity);
+    }
+
+    template<typename... Args, typename String>
+    auto fetch_pipelined(const String& query, size_t capacity) const {
+        return prepare_cached(query).template fetch_pipelined<Args...>(capacity);
+    }
+
+    // Makes whatever statement is running on this connection fail with SQLITE_INTERRUPT as soon as
+    // possible. Unlike everything else this is safe to call from another thread.
+    void interrupt() const noexcept {
+        sqlite3_interrupt(db.get());
+    }
+
+    // Calls f with the limits enforced on every statement this connection steps in the meantime,
+    // the check happens every limits.check_interval virtual machine instructions. A statement that
+    // runs past them fails with interrupted_error saying which limit was hit, as does a call
+    // to interrupt. Calls can be nested, in which case the limits of every level apply.
+    // Rows of a range returned from f are stepped after the limits are lifted, so consume them inside f.
+    template<typename F>
+    decltype(auto) with_limits(const query_limits& limits, F&& f) const {
+        static_assert(!detail::is_statement_range<std::decay_t<decltype(std::forward<F>(f)())>>::value,
+                      "the rows of a fetch have to be consumed inside f, otherwise they're stepped without any limits");
+        detail::limit_scope scope(db.get(), active_limits, limits);
+        try {
+            if(scope.expired()) {
+                throw error(SQLITE_INTERRUPT);
+            }
+            return std::forward<F>(f)();
+        }
+        catch(const interrupted_error&) {
+            throw;
+        }
+        catch(const error& e) {
+            if((e.code() & 0xff) != SQLITE_INTERRUPT) {
+                throw;
+            }
+            if(scope.tripped()) {
+                throw interrupted_error(scope.reason());
+            }
+            if(scope.has_parent()) {
+                // one of the enclosing calls knows why
+                throw;
+            }
+            throw interrupted_error(interrupted_error::interrupted);
+        }
+    }
+
+    // e.g.
+    // auto ids = con.with_timeout(std::chrono::milliseconds(50), [&] {
+    //     std::vector<int> result;
+    //     for(auto&& row : con.fetch<int>(sql)) {
+    //         result.push_back(row.get<0>());
+    //     }
+    //     return result;
+    // });
+    template<typename Rep, typename Period, typename F>
+    decltype(auto) with_timeout(std::chrono::duration<Rep, Period> budget, F&& f) const {
+        query_limits limits;
+        limits.deadline = query_limits::clock::now() + std::chrono::duration_cast<query_limits::clock::duration>(budget);
+        return with_limits(limits, std::forward<F>(f));
+    }
+
+    template<typename F>
+    decltype(auto) with_cancellation(const cancellation_token& token, F&& f) const {
+        query_limits limits;
+        limits.token = &token;
+        return with_limits(limits, std::forward<F>(f));
+    }
+
+    ::sqlite::transaction transaction(::sqlite::transaction::mode m = ::sqlite::transaction::deferred) const {
+        return { *this, m };
+    }
+
+    ::sqlite::savepoint savepoint() const {
         return { *this };
     }
 private:
+    friend struct ::sqlite::transaction;
+    friend struct ::sqlite::savepoint;
+
+    detail::transaction_control& control_statements() const {
+        if(!control || control->handle() != db.get()) {
+            control = std::make_unique<detail::transaction_control>(db.get());
+        }
+        return *control;
+    }
+
     struct deleter {
         void operator()(sqlite3* db) const noexcept {
-            sqlite3_close(db);
+            // v2 defers the close until every outstanding statement is finalized
+            sqlite3_close_v2(db);
         }
     };
 
     std::unique_ptr<sqlite3, deleter> db;
+    std::unique_ptr<statement_cache> cache;
+    mutable std::unique_ptr<detail::transaction_control> control;
+    std::unique_ptr<profiler> prof;
+    std::unique_ptr<busy_handler> busy;
+    mutable detail::limit_scope* active_limits = nullptr;
 };
 } // sqlite
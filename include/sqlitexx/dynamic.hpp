@@ -0,0 +1,349 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <sqlitexx/type_traits.hpp>
+#include <sqlitexx/error.hpp>
+#include <sqlitexx/statement.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <sqlite3.h>
+
+namespace sqlite {
+struct text_ref {
+    const char* data;
+    size_t size;
+
+#if SQLITEXX_HAS_STRING_VIEW
+    operator std::string_view() const noexcept {
+        return { data, size };
+    }
+#endif
+};
+
+// A single column of a dynamic_row holding whatever type SQLite returned for it. Numbers and
+// text or blobs shorter than inline_capacity bytes are stored inline, anything longer points
+// into the arena of the row it was read from and is only valid until that row is read again.
+struct value {
+    static constexpr size_t inline_capacity = 16;
+
+    // one of SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT, SQLITE_BLOB or SQLITE_NULL
+    int type() const noexcept {
+        return kind;
+    }
+
+    bool is_null() const noexcept {
+        return kind == SQLITE_NULL;
+    }
+
+    // integers and reals convert between each other, everything else is 0
+    sqlite3_int64 as_integer() const noexcept {
+        return kind == SQLITE_INTEGER ? storage.integer : kind == SQLITE_FLOAT ? static_cast<sqlite3_int64>(storage.real) : 0;
+    }
+
+    double as_real() const noexcept {
+        return kind == SQLITE_FLOAT ? storage.real : kind == SQLITE_INTEGER ? static_cast<double>(storage.integer) : 0.0;
+    }
+
+    // the bytes of a text or blob, text is null terminated. null for any other type
+    const char* data() const noexcept {
+        if(kind != SQLITE_TEXT && kind != SQLITE_BLOB) {
+            return nullptr;
+        }
+        return is_inline() ? storage.buffer : storage.pointer;
+    }
+
+    size_t size() const noexcept {
+        return length;
+    }
+
+    text_ref as_text() const noexcept {
+        auto str = kind == SQLITE_TEXT ? data() : nullptr;
+        return { str ? str : "", str ? length : 0 };
+    }
+
+    ::sqlite::blob as_blob() const noexcept {
+        auto bytes = kind == SQLITE_BLOB ? data() : nullptr;
+        return { reinterpret_cast<const unsigned char*>(bytes), bytes ? static_cast<int>(length) : 0 };
+    }
+
+    // the bytes of a text or blob as a string, empty for any other type
+    std::string as_string() const {
+        auto bytes = data();
+        return bytes ? std::string(bytes, length) : std::string();
+    }
+
+    // Calls f with a sqlite3_int64, double, text_ref, blob or nullptr depending on the type.
+    // Every overload of f has to return the same type.
+    template<typename Visitor>
+    decltype(auto) visit(Visitor&& f) const {
+        switch(kind) {
+        case SQLITE_INTEGER:
+            return std::forward<Visitor>(f)(storage.integer);
+        case SQLITE_FLOAT:
+            return std::forward<Visitor>(f)(storage.real);
+        case SQLITE_TEXT:
+            return std::forward<Visitor>(f)(as_text());
+        case SQLITE_BLOB:
+            return std::forward<Visitor>(f)(as_blob());
+        default:
+            return std::forward<Visitor>(f)(nullptr);
+        }
+    }
+private:
+    friend struct dynamic_row;
+
+    bool is_inline() const noexcept {
+        return length < inline_capacity;
+    }
+
+    // large values are appended to arena and only remember their offset, the
+    // pointer is patched in by fix once the whole row has been read
+    void read(sqlite3_stmt* ptr, int index, std::vector<char>& arena) {
+        kind = sqlite3_column_type(ptr, index);
+        const void* bytes = nullptr;
+        if(kind == SQLITE_INTEGER) {
+            storage.integer = sqlite3_column_int64(ptr, index);
+        }
+        else if(kind == SQLITE_FLOAT) {
+            storage.real = sqlite3_column_double(ptr, index);
+        }
+        else if(kind == SQLITE_TEXT) {
+            bytes = sqlite3_column_text(ptr, index);
+        }
+        else if(kind == SQLITE_BLOB) {
+            bytes = sqlite3_column_blob(ptr, index);
+        }
+
+        if(kind != SQLITE_TEXT && kind != SQLITE_BLOB) {
+            length = 0;
+            return;
+        }
+
+        length = static_cast<uint32_t>(sqlite3_column_bytes(ptr, index));
+        char* out = storage.buffer;
+        if(!is_inline()) {
+            storage.offset = arena.size();
+            arena.resize(arena.size() + length + 1);
+            out = arena.data() + storage.offset;
+        }
+        if(length != 0) {
+            std::memcpy(out, bytes, length);
+        }
+        out[length] = '\0';
+    }
+
+    void fix(const char* base) noexcept {
+        if((kind == SQLITE_TEXT || kind == SQLITE_BLOB) && !is_inline()) {
+            storage.pointer = base + storage.offset;
+        }
+    }
+
+    // points a value copied along with its arena at the copy of the arena
+    void rebase(const char* from, const char* to) noexcept {
+        if((kind == SQLITE_TEXT || kind == SQLITE_BLOB) && !is_inline()) {
+            storage.pointer = to + (storage.pointer - from);
+        }
+    }
+
+    union {
+        sqlite3_int64 integer;
+        double real;
+        const char* pointer;
+        size_t offset;
+        char buffer[inline_capacity];
+    } storage;
+    uint32_t length = 0;
+    int kind = SQLITE_NULL;
+};
+
+// A row of any shape, read through sqlite3_column_type. Meant to be reused: reading another
+// row keeps the storage of the previous one, so once it has grown to fit the largest row
+// a scan doesn't allocate at all. e.g.
+//
+// for(auto&& row : stmt.fetch<sqlite::dynamic_row>()) {
+//     for(auto&& v : row) { ... }
+// }
+struct dynamic_row {
+    using iterator = std::vector<value>::const_iterator;
+
+    dynamic_row() noexcept = default;
+
+    // long values point into the arena so a copy has to point them at its own
+    dynamic_row(const dynamic_row& o): stmt(o.stmt), values(o.values), arena(o.arena) {
+        rebase(o.arena.data());
+    }
+
+    dynamic_row& operator=(const dynamic_row& o) {
+        if(this != &o) {
+            stmt = o.stmt;
+            values = o.values;
+            arena = o.arena;
+            rebase(o.arena.data());
+        }
+        return *this;
+    }
+
+    // moving a vector keeps its buffer so the pointers stay valid
+    dynamic_row(dynamic_row&&) noexcept = default;
+    dynamic_row& operator=(dynamic_row&&) noexcept = default;
+
+    // decodes the current row of a statement that was just stepped
+    void read(sqlite3_stmt* ptr) {
+        stmt = ptr;
+        arena.clear();
+        int n = sqlite3_column_count(ptr);
+        values.resize(static_cast<size_t>(n));
+        for(int i = 0; i < n; ++i) {
+            values[i].read(ptr, i, arena);
+        }
+
+        // the arena might have moved while it grew
+        for(auto&& v : values) {
+            v.fix(arena.data());
+        }
+    }
+
+    size_t size() const noexcept {
+        return values.size();
+    }
+
+    bool empty() const noexcept {
+        return values.empty();
+    }
+
+    const value& operator[](size_t index) const noexcept {
+        return values[index];
+    }
+
+    const value& at(size_t index) const {
+        if(index >= values.size()) {
+            throw error(SQLITE_RANGE);
+        }
+        return values[index];
+    }
+
+    // only valid while the statement the row was read from is alive
+    const char* name(size_t index) const noexcept {
+        return sqlite3_column_name(stmt, static_cast<int>(index));
+    }
+
+    iterator begin() const noexcept {
+        return values.begin();
+    }
+
+    iterator end() const noexcept {
+        return values.end();
+    }
+private:
+    sqlite3_stmt* stmt = nullptr;
+    void rebase(const char* from) noexcept {
+        for(auto&& v : values) {
+            v.rebase(from, arena.data());
+        }
+    }
+
+    std::vector<value> values;
+    std::vector<char> arena;
+};
+
+namespace detail {
+struct dynamic_iterator {
+    using difference_type = std::ptrdiff_t;
+    using value_type = dynamic_row;
+    using reference = const dynamic_row&;
+    using pointer = const dynamic_row*;
+    using iterator_category = std::input_iterator_tag;
+
+    dynamic_iterator(sqlite3_stmt* ptr): ptr(ptr) {
+        advance();
+    }
+
+    dynamic_iterator(sqlite3_stmt* ptr, int ret) noexcept: ptr(ptr), ret(ret) {}
+
+    bool operator==(const dynamic_iterator& other) const noexcept {
+        return ptr == other.ptr && ret == other.ret;
+    }
+
+    bool operator!=(const dynamic_iterator& other) const noexcept {
+        return !(*this == other);
+    }
+
+    dynamic_iterator& operator++() {
+        advance();
+        return *this;
+    }
+
+    reference operator*() const noexcept {
+        return row;
+    }
+
+    pointer operator->() const noexcept {
+        return &row;
+    }
+private:
+    sqlite3_stmt* ptr;
+    int ret = SQLITE_OK;
+    dynamic_row row;
+
+    void advance() {
+        if(ret != SQLITE_DONE) {
+            ret = sqlite3_step(ptr);
+            if(ret == SQLITE_ROW) {
+                row.read(ptr);
+            }
+            else if(ret != SQLITE_DONE) {
+                throw error(ret);
+            }
+        }
+    }
+};
+
+template<typename Pointer>
+struct dynamic_range {
+    using iterator = dynamic_iterator;
+    Pointer _ptr;
+
+    iterator begin() const {
+        reset();
+        return { _ptr.get() };
+    }
+
+    iterator end() const {
+        return { _ptr.get(), SQLITE_DONE };
+    }
+
+    void reset() const {
+        int ret = sqlite3_reset(_ptr.get());
+        if(ret != SQLITE_OK) {
+            throw error(ret);
+        }
+    }
+};
+} // detail
+} // sqlite
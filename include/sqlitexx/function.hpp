@@ -0,0 +1,430 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <sqlitexx/type_traits.hpp>
+#include <sqlitexx/error.hpp>
+#include <sqlitexx/statement.hpp>
+
+#include <exception>
+#include <memory>
+#include <new>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <sqlite3.h>
+
+namespace sqlite {
+// flags for connection::create_function and friends
+struct function_flags {
+    enum : int {
+        none          = 0,
+        // the same arguments always give the same result, required to use the function in an index or CHECK
+        deterministic = SQLITE_DETERMINISTIC,
+#if SQLITE_VERSION_NUMBER >= 3030000
+        direct_only   = SQLITE_DIRECTONLY,
+#endif
+#if SQLITE_VERSION_NUMBER >= 3031000
+        // no side effects, so it's safe to call from schema objects such as views and triggers
+        innocuous     = SQLITE_INNOCUOUS,
+#endif
+    };
+};
+
+namespace meta {
+// converts a function argument to T
+template<typename T, typename = void>
+struct value_traits;
+
+template<typename T>
+struct value_traits<T, std::enable_if_t<std::is_floating_point<T>::value>> {
+    static T convert(sqlite3_value* value) noexcept {
+        return sqlite3_value_double(value);
+    }
+};
+
+template<typename T>
+struct value_traits<T, std::enable_if_t<is_integer<T>::value>> {
+    static T do_integer_convert(sqlite3_value* value, std::true_type) noexcept {
+        return sqlite3_value_int(value);
+    }
+
+    static T do_integer_convert(sqlite3_value* value, std::false_type) noexcept {
+        return sqlite3_value_int64(value);
+    }
+
+    static T convert(sqlite3_value* value) noexcept {
+        return do_integer_convert(value, std::integral_constant<bool, (sizeof(T) < 8)>{});
+    }
+};
+
+// the raw value, for checking sqlite3_value_type and the like
+template<>
+struct value_traits<sqlite3_value*> {
+    static sqlite3_value* convert(sqlite3_value* value) noexcept {
+        return value;
+    }
+};
+
+template<>
+struct value_traits<const char*> {
+    static const char* convert(sqlite3_value* value) noexcept {
+        return reinterpret_cast<const char*>(sqlite3_value_text(value));
+    }
+};
+
+template<>
+struct value_traits<const char16_t*> {
+    static const char16_t* convert(sqlite3_value* value) noexcept {
+        return static_cast<const char16_t*>(sqlite3_value_text16(value));
+    }
+};
+
+template<typename... Args>
+struct value_traits<std::basic_string<char, Args...>> {
+    using return_type = std::basic_string<char, Args...>;
+
+    static return_type convert(sqlite3_value* value) {
+        auto str = reinterpret_cast<const char*>(sqlite3_value_text(value));
+        int bytes = sqlite3_value_bytes(value);
+        return bytes ? return_type(str, bytes) : return_type();
+    }
+};
+
+template<typename... Args>
+struct value_traits<std::basic_string<char16_t, Args...>> {
+    using return_type = std::basic_string<char16_t, Args...>;
+
+    static return_type convert(sqlite3_value* value) {
+        auto str = static_cast<const char16_t*>(sqlite3_value_text16(value));
+        int bytes = sqlite3_value_bytes16(value);
+        return bytes ? return_type(str, bytes / 2) : return_type();
+    }
+};
+
+#if SQLITEXX_HAS_STRING_VIEW
+// only valid until the function returns
+template<typename Traits>
+struct value_traits<std::basic_string_view<char, Traits>> {
+    static std::basic_string_view<char, Traits> convert(sqlite3_value* value) noexcept {
+        auto str = reinterpret_cast<const char*>(sqlite3_value_text(value));
+        return { str, static_cast<size_t>(sqlite3_value_bytes(value)) };
+    }
+};
+#endif
+
+// only valid until the function returns
+template<>
+struct value_traits<blob> {
+    static blob convert(sqlite3_value* value) noexcept {
+        return { static_cast<const unsigned char*>(sqlite3_value_blob(value)), sqlite3_value_bytes(value) };
+    }
+};
+
+// sets the result of a function from T
+template<typename T, typename = void>
+struct result_traits;
+
+template<typename T>
+struct result_traits<T, std::enable_if_t<std::is_floating_point<T>::value>> {
+    static void set(sqlite3_context* ctx, T value) noexcept {
+        sqlite3_result_double(ctx, value);
+    }
+};
+
+template<typename T>
+struct result_traits<T, std::enable_if_t<is_integer<T>::value>> {
+    static void do_integer_set(sqlite3_context* ctx, T value, std::true_type) noexcept {
+        sqlite3_result_int(ctx, value);
+    }
+
+    static void do_integer_set(sqlite3_context* ctx, T value, std::false_type) noexcept {
+        sqlite3_result_int64(ctx, value);
+    }
+
+    static void set(sqlite3_context* ctx, T value) noexcept {
+        do_integer_set(ctx, value, std::integral_constant<bool, (sizeof(T) < 8)>{});
+    }
+};
+
+template<>
+struct result_traits<decltype(nullptr)> {
+    static void set(sqlite3_context* ctx, decltype(nullptr)) noexcept {
+        sqlite3_result_null(ctx);
+    }
+};
+
+template<>
+struct result_traits<const char*> {
+    static void set(sqlite3_context* ctx, const char* str) noexcept {
+        sqlite3_result_text(ctx, str, -1, SQLITE_TRANSIENT);
+    }
+};
+
+template<typename... Args>
+struct result_traits<std::basic_string<char, Args...>> {
+    static void set(sqlite3_context* ctx, const std::basic_string<char, Args...>& str) noexcept {
+        sqlite3_result_text(ctx, str.data(), static_cast<int>(str.size()), SQLITE_TRANSIENT);
+    }
+};
+
+template<typename... Args>
+struct result_traits<std::basic_string<char16_t, Args...>> {
+    static void set(sqlite3_context* ctx, const std::basic_string<char16_t, Args...>& str) noexcept {
+        sqlite3_result_text16(ctx, str.data(), static_cast<int>(str.size() * sizeof(char16_t)), SQLITE_TRANSIENT);
+    }
+};
+
+#if SQLITEXX_HAS_STRING_VIEW
+template<typename Traits>
+struct result_traits<std::basic_string_view<char, Traits>> {
+    static void set(sqlite3_context* ctx, std::basic_string_view<char, Traits> str) noexcept {
+        sqlite3_result_text(ctx, str.data(), static_cast<int>(str.size()), SQLITE_TRANSIENT);
+    }
+};
+#endif
+
+template<>
+struct result_traits<blob> {
+    static void set(sqlite3_context* ctx, const blob& value) noexcept {
+        sqlite3_result_blob(ctx, value.data, value.length, SQLITE_TRANSIENT);
+    }
+};
+
+template<>
+struct result_traits<zeroblob> {
+    static void set(sqlite3_context* ctx, const zeroblob& value) noexcept {
+        sqlite3_result_zeroblob64(ctx, value.size);
+    }
+};
+} // meta
+
+namespace detail {
+template<typename T>
+struct callable_traits : callable_traits<decltype(&T::operator())> {};
+
+template<typename R, typename... Args>
+struct callable_traits<R(*)(Args...)> {
+    using return_type = R;
+    using arguments = std::tuple<Args...>;
+};
+
+template<typename R, typename C, typename... Args>
+struct callable_traits<R(C::*)(Args...)> : callable_traits<R(*)(Args...)> {};
+
+template<typename R, typename C, typename... Args>
+struct callable_traits<R(C::*)(Args...) const> : callable_traits<R(*)(Args...)> {};
+
+#if defined(__cpp_noexcept_function_type)
+template<typename R, typename... Args>
+struct callable_traits<R(*)(Args...) noexcept> : callable_traits<R(*)(Args...)> {};
+
+template<typename R, typename C, typename... Args>
+struct callable_traits<R(C::*)(Args...) noexcept> : callable_traits<R(*)(Args...)> {};
+
+template<typename R, typename C, typename... Args>
+struct callable_traits<R(C::*)(Args...) const noexcept> : callable_traits<R(*)(Args...)> {};
+#endif
+
+template<typename T>
+using function_arguments = typename callable_traits<T>::arguments;
+
+// calls f with every argument converted to the type the callable asked for
+template<typename F, typename... Args, size_t... I>
+decltype(auto) apply_values(F&& f, sqlite3_value** argv, std::tuple<Args...>*, std::index_sequence<I...>) {
+    return f(meta::value_traits<meta::unqualified_t<Args>>::convert(argv[I])...);
+}
+
+template<typename Arguments, typename F>
+decltype(auto) apply_values(F&& f, sqlite3_value** argv) {
+    return apply_values(std::forward<F>(f), argv, static_cast<Arguments*>(nullptr),
+                        std::make_index_sequence<std::tuple_size<Arguments>::value>{});
+}
+
+template<typename F>
+void set_result(sqlite3_context*, F&& f, std::true_type) {
+    f();
+}
+
+template<typename F>
+void set_result(sqlite3_context* ctx, F&& f, std::false_type) {
+    meta::result_traits<meta::unqualified_t<decltype(f())>>::set(ctx, f());
+}
+
+// runs f and stores what it returns as the result, exceptions are reported as SQL errors
+template<typename F>
+void set_result(sqlite3_context* ctx, F&& f) noexcept {
+    try {
+        set_result(ctx, std::forward<F>(f), std::is_void<decltype(f())>{});
+    }
+    catch(const std::bad_alloc&) {
+        sqlite3_result_error_nomem(ctx);
+    }
+    catch(const error& e) {
+        sqlite3_result_error_code(ctx, e.code());
+    }
+    catch(const std::exception& e) {
+        sqlite3_result_error(ctx, e.what(), -1);
+    }
+    catch(...) {
+        sqlite3_result_error(ctx, "unknown exception thrown from a user defined function", -1);
+    }
+}
+
+template<typename F>
+struct scalar_function {
+    using arguments = function_arguments<F>;
+
+    static void call(sqlite3_context* ctx, int, sqlite3_value** argv) noexcept {
+        auto&& f = static_cast<scalar_function*>(sqlite3_user_data(ctx))->f;
+        set_result(ctx, [&] { return apply_values<arguments>(f, argv); });
+    }
+
+    static void destroy(void* ptr) noexcept {
+        delete static_cast<scalar_function*>(ptr);
+    }
+
+    F f;
+};
+
+// Each group gets its own copy of the prototype, created on the first row.
+// The aggregate context only holds a pointer to it since the state isn't trivially constructible.
+template<typename Aggregate>
+struct aggregate_function {
+    using arguments = function_arguments<decltype(&Aggregate::step)>;
+
+    static aggregate_function& self(sqlite3_context* ctx) noexcept {
+        return *static_cast<aggregate_function*>(sqlite3_user_data(ctx));
+    }
+
+    static Aggregate** state(sqlite3_context* ctx, bool create) noexcept {
+        return static_cast<Aggregate**>(sqlite3_aggregate_context(ctx, create ? sizeof(Aggregate*) : 0));
+    }
+
+    static void step(sqlite3_context* ctx, int, sqlite3_value** argv) noexcept {
+        auto slot = state(ctx, true);
+        if(slot == nullptr) {
+            sqlite3_result_error_nomem(ctx);
+            return;
+        }
+
+        set_result(ctx, [&] {
+            if(*slot == nullptr) {
+                *slot = new Aggregate(self(ctx).prototype);
+            }
+            auto&& agg = **slot;
+            apply_values<arguments>([&](auto&&... args) { agg.step(std::forward<decltype(args)>(args)...); }, argv);
+        });
+    }
+
+    static void inverse(sqlite3_context* ctx, int, sqlite3_value** argv) noexcept {
+        auto slot = state(ctx, false);
+        if(slot == nullptr || *slot == nullptr) {
+            return;
+        }
+
+        auto&& agg = **slot;
+        set_result(ctx, [&] {
+            apply_values<arguments>([&](auto&&... args) { agg.inverse(std::forward<decltype(args)>(args)...); }, argv);
+        });
+    }
+
+    static void value(sqlite3_context* ctx) noexcept {
+        auto slot = state(ctx, false);
+        if(slot == nullptr || *slot == nullptr) {
+            set_result(ctx, [&] {
+                Aggregate empty(self(ctx).prototype);
+                return empty.value();
+            });
+            return;
+        }
+
+        auto&& agg = **slot;
+        set_result(ctx, [&] { return agg.value(); });
+    }
+
+    static void final(sqlite3_context* ctx) noexcept {
+        auto slot = state(ctx, false);
+        if(slot == nullptr || *slot == nullptr) {
+            // no rows in the group
+            set_result(ctx, [&] {
+                Aggregate empty(self(ctx).prototype);
+                return empty.final();
+            });
+            return;
+        }
+
+        std::unique_ptr<Aggregate> agg(*slot);
+        *slot = nullptr;
+        set_result(ctx, [&] { return agg->final(); });
+    }
+
+    static void destroy(void* ptr) noexcept {
+        delete static_cast<aggregate_function*>(ptr);
+    }
+
+    Aggregate prototype;
+};
+
+template<typename F>
+inline void create_function(sqlite3* db, const char* name, F f, int flags) {
+    using function = scalar_function<F>;
+    std::unique_ptr<function> ptr(new function{ std::move(f) });
+    int nargs = std::tuple_size<typename function::arguments>::value;
+    // SQLite calls the destructor itself if registering fails
+    int ret = sqlite3_create_function_v2(db, name, nargs, SQLITE_UTF8 | flags, ptr.release(),
+                                         &function::call, nullptr, nullptr, &function::destroy);
+    if(ret != SQLITE_OK) {
+        throw error(ret);
+    }
+}
+
+template<typename Aggregate>
+inline void create_aggregate(sqlite3* db, const char* name, Aggregate prototype, int flags) {
+    using function = aggregate_function<Aggregate>;
+    std::unique_ptr<function> ptr(new function{ std::move(prototype) });
+    int nargs = std::tuple_size<typename function::arguments>::value;
+    int ret = sqlite3_create_function_v2(db, name, nargs, SQLITE_UTF8 | flags, ptr.release(),
+                                         nullptr, &function::step, &function::final, &function::destroy);
+    if(ret != SQLITE_OK) {
+        throw error(ret);
+    }
+}
+
+#if SQLITE_VERSION_NUMBER >= 3025000
+template<typename Aggregate>
+inline void create_window_function(sqlite3* db, const char* name, Aggregate prototype, int flags) {
+    using function = aggregate_function<Aggregate>;
+    std::unique_ptr<function> ptr(new function{ std::move(prototype) });
+    int nargs = std::tuple_size<typename function::arguments>::value;
+    int ret = sqlite3_create_window_function(db, name, nargs, SQLITE_UTF8 | flags, ptr.release(),
+                                             &function::step, &function::final, &function::value,
+                                             &function::inverse, &function::destroy);
+    if(ret != SQLITE_OK) {
+        throw error(ret);
+    }
+}
+#endif
+} // detail
+} // sqlite
@@ -0,0 +1,167 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <sqlitexx/error.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <sqlite3.h>
+
+namespace sqlite {
+// A shared flag that cancels every query running under it, see connection::with_cancellation.
+// Copies refer to the same flag so one can be handed to another thread and cancelled from there.
+struct cancellation_token {
+    cancellation_token(): state(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void cancel() const noexcept {
+        state->store(true, std::memory_order_relaxed);
+    }
+
+    bool is_cancelled() const noexcept {
+        return state->load(std::memory_order_relaxed);
+    }
+
+    void reset() const noexcept {
+        state->store(false, std::memory_order_relaxed);
+    }
+private:
+    std::shared_ptr<std::atomic<bool>> state;
+};
+
+// Thrown instead of a plain SQLITE_INTERRUPT error by connection::with_limits and friends.
+struct interrupted_error : error {
+    enum reason_type : int {
+        // sqlite3_interrupt was called, e.g. through connection::interrupt
+        interrupted,
+        deadline,
+        cancelled
+    };
+
+    explicit interrupted_error(reason_type why) noexcept: error(SQLITE_INTERRUPT), why(why) {}
+
+    const char* what() const noexcept override {
+        static const char* const reasons[] = {
+            "query interrupted",
+            "query deadline exceeded",
+            "query cancelled"
+        };
+        return reasons[why];
+    }
+
+    reason_type reason() const noexcept {
+        return why;
+    }
+private:
+    reason_type why;
+};
+
+struct query_limits {
+    using clock = std::chrono::steady_clock;
+
+    clock::time_point deadline = clock::time_point::max();
+    const cancellation_token* token = nullptr;
+    // number of virtual machine instructions between checks, lower reacts faster but costs more
+    int check_interval = 1000;
+};
+
+namespace detail {
+// Installs a progress handler enforcing a set of limits for as long as it lives. Scopes nest:
+// the innermost one owns the handler and checks the limits of every enclosing scope as well,
+// then hands the handler back to its parent when destroyed.
+struct limit_scope {
+    limit_scope(sqlite3* db, limit_scope*& top, const query_limits& limits) noexcept:
+        db(db), top(top), parent(top), limits(limits) {
+        top = this;
+        install();
+    }
+
+    limit_scope(const limit_scope&) = delete;
+    limit_scope& operator=(const limit_scope&) = delete;
+
+    ~limit_scope() {
+        top = parent;
+        if(parent) {
+            parent->install();
+        }
+        else {
+            sqlite3_progress_handler(db, 0, nullptr, nullptr);
+        }
+    }
+
+    // returns true when this scope or an enclosing one ran out, recording why in the scope that did
+    bool expired() noexcept {
+        for(auto scope = this; scope != nullptr; scope = scope->parent) {
+            if(scope->check()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool has_parent() const noexcept {
+        return parent != nullptr;
+    }
+
+    // whether this particular scope is the one that stopped the query
+    bool tripped() const noexcept {
+        return fired;
+    }
+
+    interrupted_error::reason_type reason() const noexcept {
+        return why;
+    }
+private:
+    static int callback(void* context) noexcept {
+        return static_cast<limit_scope*>(context)->expired();
+    }
+
+    void install() noexcept {
+        sqlite3_progress_handler(db, limits.check_interval, &limit_scope::callback, this);
+    }
+
+    bool check() noexcept {
+        if(limits.token != nullptr && limits.token->is_cancelled()) {
+            why = interrupted_error::cancelled;
+        }
+        else if(limits.deadline != query_limits::clock::time_point::max() && query_limits::clock::now() >= limits.deadline) {
+            why = interrupted_error::deadline;
+        }
+        else {
+            return false;
+        }
+        fired = true;
+        return true;
+    }
+
+    sqlite3* db;
+    limit_scope*& top;
+    limit_scope* parent;
+    query_limits limits;
+    interrupted_error::reason_type why = interrupted_error::interrupted;
+    bool fired = false;
+};
+} // detail
+} // sqlite
@@ -0,0 +1,246 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <sqlitexx/type_traits.hpp>
+#include <sqlitexx/error.hpp>
+
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <sqlite3.h>
+
+namespace sqlite {
+// Specialize this to map a struct's fields to columns, e.g.
+//
+// template<>
+// struct row_mapping<person> {
+//     static constexpr auto fields() {
+//         return std::make_tuple(field("id", &person::id), field("name", &person::name));
+//     }
+// };
+template<typename T>
+struct row_mapping;
+
+template<typename Class, typename T>
+struct field_mapping {
+    using class_type = Class;
+    using value_type = T;
+
+    const char* name;
+    T Class::* member;
+};
+
+template<typename Class, typename T>
+constexpr field_mapping<Class, T> field(const char* name, T Class::* member) noexcept {
+    return { name, member };
+}
+
+namespace meta {
+template<typename...>
+struct make_void {
+    using type = void;
+};
+
+template<typename... Args>
+using void_t = typename make_void<Args...>::type;
+
+template<typename T, typename = void>
+struct is_mapped : std::false_type {};
+
+template<typename T>
+struct is_mapped<T, void_t<decltype(row_mapping<T>::fields())>> : std::true_type {};
+
+template<typename T>
+using field_tuple_t = decltype(row_mapping<T>::fields());
+
+template<typename T>
+struct field_count : std::tuple_size<field_tuple_t<T>> {};
+
+template<typename T, size_t N>
+using field_value_t = typename std::tuple_element_t<N, field_tuple_t<T>>::value_type;
+
+namespace detail {
+template<typename T, size_t... I>
+inline auto tie_fields(const T& value, std::index_sequence<I...>) noexcept {
+    constexpr auto fields = row_mapping<T>::fields();
+    return std::tie(value.*(std::get<I>(fields).member)...);
+}
+} // detail
+
+// a tuple of references to every mapped field, in declaration order
+template<typename T>
+inline auto tie_fields(const T& value) noexcept {
+    return detail::tie_fields(value, std::make_index_sequence<field_count<T>::value>{});
+}
+} // meta
+
+namespace detail {
+template<typename T, size_t... I>
+inline std::vector<std::string> column_names(std::index_sequence<I...>) {
+    constexpr auto fields = row_mapping<T>::fields();
+    return { std::get<I>(fields).name... };
+}
+} // detail
+
+// the mapped column names of a struct, in declaration order
+template<typename T>
+inline std::vector<std::string> column_names() {
+    return detail::column_names<T>(std::make_index_sequence<meta::field_count<T>::value>{});
+}
+
+namespace detail {
+// the column index every mapped field reads from, resolved once by name
+template<typename T>
+struct column_plan {
+    static constexpr size_t size = meta::field_count<T>::value;
+    int indices[size];
+
+    column_plan() noexcept = default;
+
+    explicit column_plan(sqlite3_stmt* ptr) {
+        constexpr auto fields = row_mapping<T>::fields();
+        int count = sqlite3_column_count(ptr);
+        resolve(ptr, count, fields, std::make_index_sequence<size>{});
+    }
+
+    void decode(sqlite3_stmt* ptr, T& value) const {
+        decode(ptr, value, std::make_index_sequence<size>{});
+    }
+private:
+    template<typename Fields, size_t... I>
+    void resolve(sqlite3_stmt* ptr, int count, const Fields& fields, std::index_sequence<I...>) {
+        using dummy = int[];
+        (void)dummy{ 0, (indices[I] = find(ptr, count, std::get<I>(fields).name), 0)... };
+    }
+
+    static int find(sqlite3_stmt* ptr, int count, const char* name) {
+        for(int i = 0; i < count; ++i) {
+            if(std::strcmp(sqlite3_column_name(ptr, i), name) == 0) {
+                return i;
+            }
+        }
+        throw error(SQLITE_RANGE);
+    }
+
+    template<size_t... I>
+    void decode(sqlite3_stmt* ptr, T& value, std::index_sequence<I...>) const {
+        constexpr auto fields = row_mapping<T>::fields();
+        using dummy = int[];
+        (void)dummy{ 0, (assign(value.*(std::get<I>(fields).member), ptr, indices[I]), 0)... };
+    }
+
+    template<typename U>
+    static void assign(U& out, sqlite3_stmt* ptr, int index) {
+        out = meta::column_traits<U>::convert(ptr, index);
+    }
+
+    // the struct is reused between rows so strings can keep their capacity
+    template<typename... Rest>
+    static void assign(std::basic_string<char, Rest...>& out, sqlite3_stmt* ptr, int index) {
+        auto str = reinterpret_cast<const char*>(sqlite3_column_text(ptr, index));
+        out.assign(str ? str : "", static_cast<size_t>(sqlite3_column_bytes(ptr, index)));
+    }
+};
+
+template<typename T>
+struct mapped_iterator {
+    using difference_type = std::ptrdiff_t;
+    using value_type = T;
+    using reference = const T&;
+    using pointer = const T*;
+    using iterator_category = std::input_iterator_tag;
+
+    mapped_iterator(sqlite3_stmt* ptr): ptr(ptr), plan(ptr) {
+        advance();
+    }
+
+    mapped_iterator(sqlite3_stmt* ptr, int ret) noexcept: ptr(ptr), ret(ret) {}
+
+    bool operator==(const mapped_iterator& other) const noexcept {
+        return ptr == other.ptr && ret == other.ret;
+    }
+
+    bool operator!=(const mapped_iterator& other) const noexcept {
+        return !(*this == other);
+    }
+
+    mapped_iterator& operator++() {
+        advance();
+        return *this;
+    }
+
+    reference operator*() const noexcept {
+        return value;
+    }
+
+    pointer operator->() const noexcept {
+        return &value;
+    }
+private:
+    sqlite3_stmt* ptr;
+    int ret = SQLITE_OK;
+    column_plan<T> plan{};
+    T value{};
+
+    void advance() {
+        if(ret != SQLITE_DONE) {
+            ret = sqlite3_step(ptr);
+            if(ret == SQLITE_ROW) {
+                plan.decode(ptr, value);
+            }
+            else if(ret != SQLITE_DONE) {
+                throw error(ret);
+            }
+        }
+    }
+};
+
+template<typename Pointer, typename T>
+struct mapped_range {
+    using iterator = mapped_iterator<T>;
+    Pointer _ptr;
+
+    iterator begin() const {
+        reset();
+        return { _ptr.get() };
+    }
+
+    iterator end() const {
+        return { _ptr.get(), SQLITE_DONE };
+    }
+
+    void reset() const {
+        int ret = sqlite3_reset(_ptr.get());
+        if(ret != SQLITE_OK) {
+            throw error(ret);
+        }
+    }
+};
+} // detail
+} // sqlite
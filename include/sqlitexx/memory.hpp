@@ -0,0 +1,182 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <sqlitexx/error.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <sqlite3.h>
+
+namespace sqlite {
+namespace detail {
+// Adapts a C++ allocator to sqlite3_mem_methods. Allocators only need
+// void* allocate(size_t) and void deallocate(void*, size_t), each block
+// is prefixed with its size so SQLite can still ask for it.
+template<typename Allocator>
+struct allocator_adapter {
+    static constexpr size_t header = alignof(std::max_align_t) < 8 ? 8 : alignof(std::max_align_t);
+
+    static Allocator*& instance() noexcept {
+        static Allocator* ptr = nullptr;
+        return ptr;
+    }
+
+    static size_t& size_of(void* ptr) noexcept {
+        return *reinterpret_cast<size_t*>(static_cast<char*>(ptr) - header);
+    }
+
+    static void* allocate(int bytes) noexcept {
+        size_t size = static_cast<size_t>(bytes);
+        void* block = nullptr;
+        try {
+            block = instance()->allocate(size + header);
+        }
+        catch(...) {
+            return nullptr;
+        }
+
+        if(block == nullptr) {
+            return nullptr;
+        }
+
+        void* ptr = static_cast<char*>(block) + header;
+        size_of(ptr) = size;
+        return ptr;
+    }
+
+    static void deallocate(void* ptr) noexcept {
+        instance()->deallocate(static_cast<char*>(ptr) - header, size_of(ptr) + header);
+    }
+
+    static void* reallocate(void* ptr, int bytes) noexcept {
+        void* result = allocate(bytes);
+        if(result != nullptr) {
+            size_t size = size_of(ptr);
+            std::memcpy(result, ptr, size < static_cast<size_t>(bytes) ? size : static_cast<size_t>(bytes));
+            deallocate(ptr);
+        }
+        return result;
+    }
+
+    static int size(void* ptr) noexcept {
+        return static_cast<int>(size_of(ptr));
+    }
+
+    static int roundup(int bytes) noexcept {
+        return (bytes + 7) & ~7;
+    }
+
+    static int init(void*) noexcept {
+        return SQLITE_OK;
+    }
+
+    static void shutdown(void*) noexcept {}
+};
+
+// what SQLite was using before the first allocator was installed
+inline sqlite3_mem_methods& default_mem_methods() noexcept {
+    static sqlite3_mem_methods methods{};
+    return methods;
+}
+
+template<typename... Args>
+inline void configure(int option, Args... args) {
+    int ret = sqlite3_config(option, args...);
+    if(ret != SQLITE_OK) {
+        throw error(ret);
+    }
+}
+} // detail
+
+// Process wide memory settings. SQLite only accepts these before it's initialized, i.e. before
+// the first connection is opened or after sqlite3_shutdown. Otherwise they throw SQLITE_MISUSE.
+namespace config {
+// turning memory statistics off removes a mutex and some bookkeeping from every allocation,
+// sqlite3_memory_used and friends stop reporting anything useful though
+inline void memory_status(bool enabled) {
+    detail::configure(SQLITE_CONFIG_MEMSTATUS, static_cast<int>(enabled));
+}
+
+// the default lookaside slot size and count for new connections, see connection::set_lookaside
+inline void lookaside(int slot_size, int slots) {
+    detail::configure(SQLITE_CONFIG_LOOKASIDE, slot_size, slots);
+}
+
+// page cache memory carved out of a caller owned buffer of at least page_size * pages bytes,
+// which has to stay alive until sqlite3_shutdown
+inline void page_cache(void* buffer, int page_size, int pages) {
+    detail::configure(SQLITE_CONFIG_PAGECACHE, buffer, page_size, pages);
+}
+
+// same as above but each connection makes one up front allocation for its pages
+inline void page_cache(int page_size, int pages) {
+    page_cache(nullptr, page_size, pages);
+}
+
+// Routes every SQLite allocation through alloc, which has to outlive SQLite's use of it.
+// Allocator needs void* allocate(size_t) and void deallocate(void*, size_t). Blocks must be
+// aligned to at least 8 bytes and allocate may either throw or return nullptr on failure.
+template<typename Allocator>
+inline void allocator(Allocator& alloc) {
+    using adapter = detail::allocator_adapter<Allocator>;
+    auto&& defaults = detail::default_mem_methods();
+    if(defaults.xMalloc == nullptr) {
+        detail::configure(SQLITE_CONFIG_GETMALLOC, &defaults);
+    }
+
+    sqlite3_mem_methods methods{};
+    methods.xMalloc = &adapter::allocate;
+    methods.xFree = &adapter::deallocate;
+    methods.xRealloc = &adapter::reallocate;
+    methods.xSize = &adapter::size;
+    methods.xRoundup = &adapter::roundup;
+    methods.xInit = &adapter::init;
+    methods.xShutdown = &adapter::shutdown;
+    adapter::instance() = &alloc;
+    detail::configure(SQLITE_CONFIG_MALLOC, &methods);
+}
+
+// goes back to SQLite's own allocator
+inline void default_allocator() {
+    auto&& defaults = detail::default_mem_methods();
+    if(defaults.xMalloc != nullptr) {
+        detail::configure(SQLITE_CONFIG_MALLOC, &defaults);
+    }
+}
+} // config
+
+// see sqlite3_db_status, values are in bytes except the lookaside counters which count slots
+struct memory_stats {
+    int lookaside_used = 0;
+    int lookaside_highwater = 0;
+    int lookaside_hits = 0;
+    int lookaside_misses_size = 0;
+    int lookaside_misses_full = 0;
+    int cache_used = 0;
+    int schema_used = 0;
+    int statement_used = 0;
+};
+} // sqlite
@@ -0,0 +1,353 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <sqlitexx/connection.hpp>
+#include <sqlitexx/pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <sqlite3.h>
+
+namespace sqlite {
+// one end of a shard's key range
+struct key_bound {
+    int type = SQLITE_NULL; // SQLITE_NULL for an open ended upper bound
+    sqlite3_int64 integer = 0;
+    double real = 0;
+    std::string text;
+};
+
+// rows with lower <= key < upper
+struct key_range {
+    key_bound lower;
+    key_bound upper;
+};
+
+struct scan_options {
+    // number of key ranges, defaults to one per reader in the pool
+    size_t shards = 0;
+};
+
+namespace detail {
+inline key_bound read_bound(sqlite3_stmt* ptr, int index) {
+    key_bound bound;
+    bound.type = sqlite3_column_type(ptr, index);
+    switch(bound.type) {
+    case SQLITE_INTEGER:
+        bound.integer = sqlite3_column_int64(ptr, index);
+        break;
+    case SQLITE_FLOAT:
+        bound.real = sqlite3_column_double(ptr, index);
+        break;
+    case SQLITE_TEXT:
+        bound.text.assign(reinterpret_cast<const char*>(sqlite3_column_text(ptr, index)),
+                          static_cast<size_t>(sqlite3_column_bytes(ptr, index)));
+        break;
+    case SQLITE_NULL:
+        break;
+    default:
+        // blobs sort after everything so there's nothing to bound them with
+        throw error(SQLITE_MISMATCH);
+    }
+    return bound;
+}
+
+// an open upper bound binds the smallest value of the next storage class, so the
+// comparison still uses the index: +inf above numbers and an empty blob above text
+inline int bind_bound(sqlite3_stmt* ptr, int index, const key_bound& bound, bool text_keys) noexcept {
+    switch(bound.type) {
+    case SQLITE_INTEGER:
+        return sqlite3_bind_int64(ptr, index, bound.integer);
+    case SQLITE_FLOAT:
+        return sqlite3_bind_double(ptr, index, bound.real);
+    case SQLITE_TEXT:
+        return sqlite3_bind_text(ptr, index, bound.text.data(), static_cast<int>(bound.text.size()), SQLITE_STATIC);
+    default:
+        if(text_keys) {
+            return sqlite3_bind_zeroblob(ptr, index, 0);
+        }
+        return sqlite3_bind_double(ptr, index, std::numeric_limits<double>::infinity());
+    }
+}
+
+// the row count ANALYZE recorded for the table, -1 if there isn't one
+inline sqlite3_int64 analyzed_rows(const connection& con, const std::string& table) {
+    try {
+        for(auto&& row : con.fetch<const char*>("SELECT stat FROM sqlite_stat1 WHERE tbl = ? AND stat IS NOT NULL LIMIT 1;", table)) {
+            return std::strtoll(row.get<0>(), nullptr, 10);
+        }
+    }
+    catch(const error&) {
+        // no sqlite_stat1 table
+    }
+    return -1;
+}
+
+// Splits the key space into at most shards ranges. Dense integer keys such as a rowid are split
+// into equal widths straight from min and max. Anything else is split at row quantiles found by
+// walking the key's index with OFFSET, using the ANALYZE row count when there is one.
+inline std::vector<key_range> split_key_space(const connection& con, const std::string& table, const std::string& key,
+                                              size_t shards, bool& text_keys) {
+    auto from = " FROM " + quote_identifier(table);
+    auto column = quote_identifier(key);
+
+    key_bound first, last;
+    for(auto&& row : con.prepare("SELECT min(" + column + "), max(" + column + ")" + from + ";").template fetch<>()) {
+        first = read_bound(row.data(), 0);
+        last = read_bound(row.data(), 1);
+    }
+
+    // text sorts after every number, so a column that mixes them needs the open upper bound above text
+    text_keys = last.type == SQLITE_TEXT;
+    std::vector<key_range> ranges;
+    if(first.type == SQLITE_NULL) {
+        return ranges;
+    }
+
+    shards = std::max<size_t>(shards, 1);
+    std::vector<key_bound> cuts;
+    sqlite3_int64 rows = analyzed_rows(con, table);
+    if(first.type == SQLITE_INTEGER && last.type == SQLITE_INTEGER) {
+        auto span = static_cast<uint64_t>(last.integer) - static_cast<uint64_t>(first.integer);
+        // only fall back to sampling when the statistics say the keys are sparse
+        if(rows < 0 || static_cast<uint64_t>(rows) >= span / 4) {
+            for(size_t i = 1; i < shards; ++i) {
+                key_bound cut;
+                cut.type = SQLITE_INTEGER;
+                cut.integer = static_cast<sqlite3_int64>(static_cast<uint64_t>(first.integer) + span / shards * i);
+                cuts.push_back(cut);
+            }
+        }
+    }
+
+    if(cuts.empty() && shards > 1) {
+        if(rows < 0) {
+            for(auto&& row : con.fetch<long long>("SELECT count(" + column + ")" + from + ";")) {
+                rows = row.get<0>();
+            }
+        }
+
+        auto sample = con.prepare("SELECT " + column + from + " WHERE " + column + " IS NOT NULL ORDER BY " +
+                                  column + " LIMIT 1 OFFSET ?;");
+        for(size_t i = 1; i < shards; ++i) {
+            sample.reset();
+            sample.bind(static_cast<long long>(static_cast<uint64_t>(rows) * i / shards));
+            for(auto&& row : sample.template fetch<>()) {
+                cuts.push_back(read_bound(row.data(), 0));
+            }
+        }
+    }
+
+    key_bound lower = first;
+    for(auto&& cut : cuts) {
+        // skewed keys can produce the same cut twice
+        bool same = cut.type == lower.type && cut.integer == lower.integer && cut.real == lower.real && cut.text == lower.text;
+        if(!same) {
+            ranges.push_back({ lower, cut });
+            lower = cut;
+        }
+    }
+    ranges.push_back({ lower, key_bound{} });
+    return ranges;
+}
+} // detail
+
+// Runs a query over disjoint key ranges of a table in parallel, one reader connection of the
+// pool per range. The query restricts the key through the :lo and :hi parameters, e.g.
+// "SELECT id, score FROM data WHERE id >= :lo AND id < :hi". Rows with a NULL key are never
+// visited. The ranges are computed once on construction and cover the keys in ascending order.
+//
+// Every shard runs in its own read transaction on whichever reader it gets, so the shards
+// don't share a snapshot: if the writer commits in the middle of a scan some shards see the
+// commit and others don't. Run the scan inside a quiet period if the result has to be consistent.
+//
+// The scan takes readers from the pool and waits for them, so it throws SQLITE_MISUSE when the
+// calling thread is still holding a reader lease from the same pool (including from inside the
+// callbacks) rather than risk waiting on itself.
+struct parallel_scan {
+    parallel_scan(connection_pool& pool, std::string table, std::string key, scan_options opts = {}):
+        pool(pool), table(std::move(table)), key(std::move(key)) {
+        check_leases();
+        auto lease = pool.read();
+        shards = detail::split_key_space(*lease, this->table, this->key, opts.shards ? opts.shards : pool.size(), text_keys);
+    }
+
+    const std::vector<key_range>& ranges() const noexcept {
+        return shards;
+    }
+
+    // Calls f(shard, row) for every row, concurrently from several threads. Named parameters
+    // in binds are bound on every shard's statement, the first exception thrown stops the scan.
+    template<typename... Args, typename String, typename F, typename... Binding>
+    void for_each(const String& query, F&& f, const Binding&... binds) const {
+        run(query, [&](size_t shard, statement& stmt) {
+            for(auto&& row : stmt.template fetch<Args...>()) {
+                f(shard, row);
+            }
+        }, binds...);
+    }
+
+    // Folds each shard with map(accumulator, row) starting from a copy of init, then combines
+    // the partial results in key order with combine(result, partial). init is used for every
+    // shard so it should be the identity of combine.
+    template<typename... Args, typename String, typename T, typename Map, typename Combine, typename... Binding>
+    T reduce(const String& query, T init, Map&& map, Combine&& combine, const Binding&... binds) const {
+        std::vector<T> partials(shards.size(), init);
+        run(query, [&](size_t shard, statement& stmt) {
+            auto&& acc = partials[shard];
+            for(auto&& row : stmt.template fetch<Args...>()) {
+                map(acc, row);
+            }
+        }, binds...);
+
+        for(auto&& partial : partials) {
+            combine(init, std::move(partial));
+        }
+        return init;
+    }
+
+    // Collects every row, rows are std::tuple<Args...> or a single mapped struct. Shards are
+    // concatenated in key order so if the query orders by the key the whole result is sorted.
+    template<typename... Args, typename String, typename... Binding>
+    auto fetch(const String& query, const Binding&... binds) const {
+        using decoder = typename detail::select_decoder<Args...>::type;
+        using row_type = typename decoder::row_type;
+        std::vector<std::vector<row_type>> parts(shards.size());
+        run(query, [&](size_t shard, statement& stmt) {
+            auto ptr = stmt.data();
+            decoder decode(ptr);
+            auto&& rows = parts[shard];
+            int ret;
+            while((ret = sqlite3_step(ptr)) == SQLITE_ROW) {
+                rows.emplace_back();
+                decode.decode(ptr, rows.back());
+            }
+            if(ret != SQLITE_DONE) {
+                throw error(ret);
+            }
+        }, binds...);
+
+        size_t total = 0;
+        for(auto&& part : parts) {
+            total += part.size();
+        }
+
+        std::vector<row_type> result;
+        result.reserve(total);
+        for(auto&& part : parts) {
+            std::move(part.begin(), part.end(), std::back_inserter(result));
+        }
+        return result;
+    }
+private:
+    template<typename String, typename Work, typename... Binding>
+    void run(const String& query, Work&& work, const Binding&... binds) const {
+        check_leases();
+        std::atomic<size_t> next{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr failure;
+        std::mutex failure_mutex;
+
+        auto worker = [&] {
+            try {
+                while(!failed.load(std::memory_order_relaxed)) {
+                    size_t shard = next++;
+                    if(shard >= shards.size()) {
+                        break;
+                    }
+
+                    auto lease = pool.read();
+                    auto stmt = lease->prepare(query);
+                    bind_range(stmt, shards[shard]);
+                    using dummy = int[];
+                    (void)dummy{ 0, (stmt.bind_to(binds.name(), binds.get()), 0)... };
+                    work(shard, stmt);
+                }
+            }
+            catch(...) {
+                std::lock_guard<std::mutex> lock(failure_mutex);
+                if(!failure) {
+                    failure = std::current_exception();
+                }
+                failed = true;
+            }
+        };
+
+        size_t count = std::min(shards.size(), pool.size());
+        std::vector<std::thread> threads;
+        for(size_t i = 1; i < count; ++i) {
+            threads.emplace_back(worker);
+        }
+        // the calling thread takes part too
+        worker();
+        for(auto&& t : threads) {
+            t.join();
+        }
+
+        if(failure) {
+            std::rethrow_exception(failure);
+        }
+    }
+
+    void check_leases() const {
+        if(pool.holds_reader()) {
+            throw error(SQLITE_MISUSE);
+        }
+    }
+
+    void bind_range(const statement& stmt, const key_range& range) const {
+        auto ptr = stmt.data();
+        int lo = sqlite3_bind_parameter_index(ptr, ":lo");
+        int hi = sqlite3_bind_parameter_index(ptr, ":hi");
+        if(lo == 0 || hi == 0) {
+            throw error(SQLITE_RANGE);
+        }
+
+        int ret = detail::bind_bound(ptr, lo, range.lower, text_keys);
+        if(ret == SQLITE_OK) {
+            ret = detail::bind_bound(ptr, hi, range.upper, text_keys);
+        }
+        if(ret != SQLITE_OK) {
+            throw error(ret);
+        }
+    }
+
+    connection_pool& pool;
+    std::string table;
+    std::string key;
+    std::vector<key_range> shards;
+    bool text_keys = false;
+};
+} // sqlite
@@ -0,0 +1,325 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <sqlitexx/type_traits.hpp>
+#include <sqlitexx/error.hpp>
+#include <sqlitexx/statement.hpp>
+#include <sqlitexx/mapping.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <sqlite3.h>
+
+namespace sqlite {
+namespace meta {
+// types that point into the statement can't cross over to another thread
+template<typename T>
+struct is_borrowed : is_any_of<T, const char*, const char16_t*, blob> {};
+
+#if SQLITEXX_HAS_STRING_VIEW
+template<typename Traits>
+struct is_borrowed<std::basic_string_view<char, Traits>> : std::true_type {};
+#endif
+} // meta
+
+namespace detail {
+template<typename... Args>
+struct tuple_decoder {
+    using row_type = std::tuple<meta::unqualified_t<Args>...>;
+
+    static_assert(!meta::or_<meta::is_borrowed<meta::unqualified_t<Args>>...>::value,
+                  "pipelined rows must own their data, use std::string or std::vector instead of pointers or views");
+
+    explicit tuple_decoder(sqlite3_stmt*) noexcept {}
+
+    void decode(sqlite3_stmt* ptr, row_type& row) const {
+        decode(ptr, row, std::make_index_sequence<sizeof...(Args)>{});
+    }
+private:
+    template<size_t... I>
+    static void decode(sqlite3_stmt* ptr, row_type& row, std::index_sequence<I...>) {
+        using dummy = int[];
+        (void)dummy{ 0, (assign(std::get<I>(row), ptr, static_cast<int>(I)), 0)... };
+    }
+
+    template<typename U>
+    static void assign(U& out, sqlite3_stmt* ptr, int index) {
+        out = meta::column_traits<U>::convert(ptr, index);
+    }
+
+    // slots are reused so strings keep their capacity between rows
+    template<typename... Rest>
+    static void assign(std::basic_string<char, Rest...>& out, sqlite3_stmt* ptr, int index) {
+        auto str = reinterpret_cast<const char*>(sqlite3_column_text(ptr, index));
+        out.assign(str ? str : "", static_cast<size_t>(sqlite3_column_bytes(ptr, index)));
+    }
+};
+
+template<typename T>
+struct mapped_decoder {
+    using row_type = T;
+
+    explicit mapped_decoder(sqlite3_stmt* ptr): plan(ptr) {}
+
+    void decode(sqlite3_stmt* ptr, row_type& row) const {
+        plan.decode(ptr, row);
+    }
+private:
+    column_plan<T> plan;
+};
+
+template<typename... Args>
+struct select_decoder {
+    using type = tuple_decoder<Args...>;
+};
+
+template<typename T>
+struct select_decoder<T> {
+    using type = std::conditional_t<meta::is_mapped<meta::unqualified_t<T>>::value,
+                                    mapped_decoder<meta::unqualified_t<T>>,
+                                    tuple_decoder<T>>;
+};
+
+// Lets one side of the ring sleep once spinning stops paying off. The other side only takes
+// the mutex when someone is actually asleep, so the fast path is a single atomic load.
+struct pipeline_signal {
+    template<typename Predicate>
+    void wait(Predicate ready) {
+        for(int i = 0; i < 64; ++i) {
+            if(ready()) {
+                return;
+            }
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        waiting.store(true);
+        cv.wait(lock, ready);
+        waiting.store(false);
+    }
+
+    void notify() {
+        if(waiting.load()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            cv.notify_one();
+        }
+    }
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::atomic<bool> waiting{false};
+};
+
+// A single producer single consumer ring of pre-allocated rows. The producer thread steps
+// and decodes into free slots while the consumer reads the ones that have been published.
+template<typename Pointer, typename Decoder>
+struct pipeline_state {
+    using row_type = typename Decoder::row_type;
+
+    pipeline_state(Pointer ptr, size_t capacity): _ptr(std::forward<Pointer>(ptr)), slots(round_up(capacity)),
+                                                  mask(slots.size() - 1) {}
+
+    ~pipeline_state() {
+        stop();
+    }
+
+    void start() {
+        int ret = sqlite3_reset(_ptr.get());
+        if(ret != SQLITE_OK) {
+            throw error(ret);
+        }
+        producer = std::thread([this] { produce(); });
+    }
+
+    void stop() noexcept {
+        if(producer.joinable()) {
+            cancelled.store(true);
+            not_full.notify();
+            producer.join();
+            sqlite3_reset(_ptr.get());
+        }
+    }
+
+    // waits until row index is available, false if the producer finished before reaching it
+    bool wait_for(size_t index) {
+        not_empty.wait([&] { return head.load() > index || finished.load(); });
+        if(head.load() > index) {
+            return true;
+        }
+
+        if(failure) {
+            std::rethrow_exception(failure);
+        }
+        return false;
+    }
+
+    void release(size_t index) {
+        tail.store(index + 1);
+        not_full.notify();
+    }
+
+    // the first row the consumer hasn't released yet
+    size_t position() const noexcept {
+        return tail.load();
+    }
+
+    const row_type& at(size_t index) const noexcept {
+        return slots[index & mask];
+    }
+private:
+    static size_t round_up(size_t capacity) noexcept {
+        size_t size = 2;
+        while(size < capacity) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    void produce() noexcept {
+        try {
+            auto ptr = _ptr.get();
+            Decoder decoder(ptr);
+            size_t index = 0;
+            while(!cancelled.load(std::memory_order_relaxed)) {
+                int ret = sqlite3_step(ptr);
+                if(ret == SQLITE_DONE) {
+                    break;
+                }
+                else if(ret != SQLITE_ROW) {
+                    throw error(ret);
+                }
+
+                not_full.wait([&] { return index - tail.load() < slots.size() || cancelled.load(); });
+                if(cancelled.load()) {
+                    break;
+                }
+
+                decoder.decode(ptr, slots[index & mask]);
+                head.store(++index);
+                not_empty.notify();
+            }
+        }
+        catch(...) {
+            failure = std::current_exception();
+        }
+
+        finished.store(true);
+        not_empty.notify();
+    }
+
+    Pointer _ptr;
+    std::vector<row_type> slots;
+    size_t mask;
+    std::exception_ptr failure;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) std::atomic<bool> finished{false};
+    std::atomic<bool> cancelled{false};
+    pipeline_signal not_empty;
+    pipeline_signal not_full;
+    std::thread producer;
+};
+
+// Rows decoded ahead of time on a separate thread. Rows are std::tuple<Args...>,
+// or the struct itself for a single mapped struct. Nothing else may use the statement
+// or its connection while iterating, the producer stops when the range is destroyed.
+template<typename Pointer, typename... Args>
+struct pipelined_range {
+    using decoder_type = typename select_decoder<Args...>::type;
+    using state_type = pipeline_state<Pointer, decoder_type>;
+    using row_type = typename decoder_type::row_type;
+
+    struct iterator {
+        using difference_type = std::ptrdiff_t;
+        using value_type = row_type;
+        using reference = const row_type&;
+        using pointer = const row_type*;
+        using iterator_category = std::input_iterator_tag;
+
+        iterator() noexcept = default;
+
+        iterator(state_type* state, size_t index): state(state), index(index) {
+            if(!state->wait_for(index)) {
+                this->state = nullptr;
+            }
+        }
+
+        bool operator==(const iterator& other) const noexcept {
+            return state == other.state && (state == nullptr || index == other.index);
+        }
+
+        bool operator!=(const iterator& other) const noexcept {
+            return !(*this == other);
+        }
+
+        iterator& operator++() {
+            state->release(index);
+            if(!state->wait_for(++index)) {
+                state = nullptr;
+            }
+            return *this;
+        }
+
+        reference operator*() const noexcept {
+            return state->at(index);
+        }
+
+        pointer operator->() const noexcept {
+            return &state->at(index);
+        }
+    private:
+        state_type* state = nullptr;
+        size_t index = 0;
+    };
+
+    pipelined_range(Pointer ptr, size_t capacity):
+        state(std::make_unique<state_type>(std::forward<Pointer>(ptr), capacity)) {}
+
+    // starts the producer, calling it again continues from the first row not yet consumed
+    iterator begin() {
+        if(!started) {
+            started = true;
+            state->start();
+        }
+        return { state.get(), state->position() };
+    }
+
+    iterator end() const noexcept {
+        return {};
+    }
+private:
+    std::unique_ptr<state_type> state;
+    bool started = false;
+};
+} // detail
+} // sqlite
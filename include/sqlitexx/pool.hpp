@@ -0,0 +1,303 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <sqlitexx/connection.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <sqlite3.h>
+
+namespace sqlite {
+struct pool_options {
+    // number of read-only connections, defaults to one per hardware thread
+    size_t readers = std::max(1u, std::thread::hardware_concurrency());
+
+    // called on every connection right after it's opened, e.g. to set pragmas
+    std::function<void(connection&)> setup;
+
+    // name of the VFS every connection is opened with, e.g. a vfs_shim, empty for the default one
+    std::string vfs;
+};
+
+struct pool_stats {
+    size_t reader_acquisitions;
+    size_t reader_waits;
+    std::chrono::nanoseconds reader_wait_time;
+    size_t readers_in_use;
+    size_t readers_peak;
+    size_t readers_total;
+    size_t writer_acquisitions;
+    size_t writer_waits;
+    std::chrono::nanoseconds writer_wait_time;
+};
+
+struct connection_pool;
+
+// RAII handle to a connection borrowed from a pool. It's given back when destroyed.
+struct pool_lease {
+    pool_lease(const pool_lease&) = delete;
+    pool_lease& operator=(const pool_lease&) = delete;
+
+    pool_lease(pool_lease&& o) noexcept: pool(o.pool), con(o.con), index(o.index) {
+        o.pool = nullptr;
+    }
+
+    pool_lease& operator=(pool_lease&& o) noexcept {
+        release();
+        pool = o.pool;
+        con = o.con;
+        index = o.index;
+        o.pool = nullptr;
+        return *this;
+    }
+
+    ~pool_lease() {
+        release();
+    }
+
+    connection& operator*() const noexcept {
+        return *con;
+    }
+
+    connection* operator->() const noexcept {
+        return con;
+    }
+
+    connection& get() const noexcept {
+        return *con;
+    }
+
+    void release() noexcept;
+private:
+    friend struct connection_pool;
+
+    pool_lease(connection_pool* pool, connection* con, uint32_t index) noexcept: pool(pool), con(con), index(index) {}
+
+    connection_pool* pool;
+    connection* con;
+    uint32_t index;
+};
+
+// A set of read-only connections plus a single writer connection on the same WAL database.
+// Acquiring a reader is a lock-free pop off a free list; only when every reader is taken
+// does the caller block. The writer is handed out to one caller at a time.
+// Leases must not outlive the pool.
+struct connection_pool {
+    template<typename String>
+    explicit connection_pool(const String& filename, pool_options opts = {}):
+        reader_count(static_cast<uint32_t>(std::max<size_t>(1, opts.readers))),
+        readers(std::make_unique<slot[]>(reader_count)) {
+        const char* vfs = opts.vfs.empty() ? nullptr : opts.vfs.c_str();
+        writer.open(filename, connection::read_write | connection::create | connection::uri | connection::no_mutex, vfs);
+        writer.execute("PRAGMA journal_mode = WAL;");
+        if(opts.setup) {
+            opts.setup(writer);
+        }
+
+        for(uint32_t i = 0; i < reader_count; ++i) {
+            readers[i].con.open(filename, connection::read_only | connection::uri | connection::no_mutex, vfs);
+            if(opts.setup) {
+                opts.setup(readers[i].con);
+            }
+            push(i);
+        }
+    }
+
+    connection_pool(const connection_pool&) = delete;
+    connection_pool& operator=(const connection_pool&) = delete;
+
+    pool_lease read() {
+        uint32_t index = pop();
+        if(index == npos) {
+            index = wait_for_reader();
+        }
+
+        readers[index].owner.store(std::this_thread::get_id(), std::memory_order_relaxed);
+        ++reader_acquisitions;
+        auto in_use = ++readers_in_use;
+        auto peak = readers_peak.load(std::memory_order_relaxed);
+        while(in_use > peak && !readers_peak.compare_exchange_weak(peak, in_use, std::memory_order_relaxed)) {}
+        return { this, &readers[index].con, index };
+    }
+
+    pool_lease write() {
+        {
+            std::unique_lock<std::mutex> lock(writer_mutex);
+            if(writer_busy) {
+                auto start = std::chrono::steady_clock::now();
+                writer_free.wait(lock, [this] { return !writer_busy; });
+                ++writer_waits;
+                writer_wait_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            }
+            writer_busy = true;
+        }
+
+        ++writer_acquisitions;
+        return { this, &writer, writer_index };
+    }
+
+    size_t size() const noexcept {
+        return reader_count;
+    }
+
+    // whether a reader lease taken on the calling thread is still out
+    bool holds_reader() const noexcept {
+        auto self = std::this_thread::get_id();
+        for(uint32_t i = 0; i < reader_count; ++i) {
+            if(readers[i].owner.load(std::memory_order_relaxed) == self) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    pool_stats stats() const noexcept {
+        pool_stats result;
+        result.reader_acquisitions = reader_acquisitions.load(std::memory_order_relaxed);
+        result.reader_waits = reader_waits.load(std::memory_order_relaxed);
+        result.reader_wait_time = std::chrono::nanoseconds(reader_wait_ns.load(std::memory_order_relaxed));
+        result.readers_in_use = readers_in_use.load(std::memory_order_relaxed);
+        result.readers_peak = readers_peak.load(std::memory_order_relaxed);
+        result.readers_total = reader_count;
+        result.writer_acquisitions = writer_acquisitions.load(std::memory_order_relaxed);
+        result.writer_waits = writer_waits.load(std::memory_order_relaxed);
+        result.writer_wait_time = std::chrono::nanoseconds(writer_wait_ns.load(std::memory_order_relaxed));
+        return result;
+    }
+private:
+    friend struct pool_lease;
+
+    static constexpr uint32_t npos = UINT32_MAX;
+    static constexpr uint32_t writer_index = UINT32_MAX - 1;
+
+    struct slot {
+        connection con;
+        std::atomic<uint32_t> next{npos};
+        std::atomic<std::thread::id> owner{};
+    };
+
+    // the free list head packs the slot index in the low half and an ABA tag in the high half
+    static uint64_t pack(uint64_t head, uint32_t index) noexcept {
+        return ((head >> 32) + 1) << 32 | index;
+    }
+
+    uint32_t pop() noexcept {
+        uint64_t head = free_head.load();
+        for(;;) {
+            auto index = static_cast<uint32_t>(head);
+            if(index == npos) {
+                return npos;
+            }
+
+            auto next = readers[index].next.load(std::memory_order_relaxed);
+            if(free_head.compare_exchange_weak(head, pack(head, next))) {
+                return index;
+            }
+        }
+    }
+
+    void push(uint32_t index) noexcept {
+        uint64_t head = free_head.load();
+        do {
+            readers[index].next.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        }
+        while(!free_head.compare_exchange_weak(head, pack(head, index)));
+    }
+
+    uint32_t wait_for_reader() {
+        auto start = std::chrono::steady_clock::now();
+        uint32_t index;
+        {
+            std::unique_lock<std::mutex> lock(wait_mutex);
+            ++waiters;
+            while((index = pop()) == npos) {
+                available.wait(lock);
+            }
+            --waiters;
+        }
+
+        ++reader_waits;
+        reader_wait_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        return index;
+    }
+
+    void release(uint32_t index) noexcept {
+        if(index == writer_index) {
+            {
+                std::lock_guard<std::mutex> lock(writer_mutex);
+                writer_busy = false;
+            }
+            writer_free.notify_one();
+            return;
+        }
+
+        readers[index].owner.store(std::thread::id{}, std::memory_order_relaxed);
+        --readers_in_use;
+        push(index);
+        if(waiters.load() != 0) {
+            std::lock_guard<std::mutex> lock(wait_mutex);
+            available.notify_one();
+        }
+    }
+
+    uint32_t reader_count;
+    std::unique_ptr<slot[]> readers;
+    std::atomic<uint64_t> free_head{npos};
+
+    std::mutex wait_mutex;
+    std::condition_variable available;
+    std::atomic<size_t> waiters{0};
+
+    // a flag rather than a held mutex so a writer lease can be released on another thread
+    connection writer;
+    std::mutex writer_mutex;
+    std::condition_variable writer_free;
+    bool writer_busy = false;
+
+    std::atomic<size_t> reader_acquisitions{0};
+    std::atomic<size_t> reader_waits{0};
+    std::atomic<int64_t> reader_wait_ns{0};
+    std::atomic<size_t> readers_in_use{0};
+    std::atomic<size_t> readers_peak{0};
+    std::atomic<size_t> writer_acquisitions{0};
+    std::atomic<size_t> writer_waits{0};
+    std::atomic<int64_t> writer_wait_ns{0};
+};
+
+inline void pool_lease::release() noexcept {
+    if(pool) {
+        pool->release(index);
+        pool = nullptr;
+    }
+}
+} // sqlite
@@ -0,0 +1,205 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <sqlitexx/error.hpp>
+#include <sqlitexx/cache.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <sqlite3.h>
+
+namespace sqlite {
+// aggregated timings and counters for every execution of one SQL text
+struct statement_profile {
+    // histogram[i] counts executions that took less than 2^i nanoseconds but at least 2^(i - 1)
+    static constexpr size_t histogram_size = 40;
+
+    std::string sql;
+    uint64_t calls = 0;
+    uint64_t rows = 0;
+    std::chrono::nanoseconds total_time{0};
+    std::chrono::nanoseconds max_time{0};
+    std::array<uint64_t, histogram_size> histogram{};
+
+    // sqlite3_stmt_status counters summed over every execution
+    uint64_t fullscan_steps = 0;
+    uint64_t sorts = 0;
+    uint64_t autoindexes = 0;
+    uint64_t vm_steps = 0;
+    uint64_t reprepares = 0;
+};
+
+// Collects per statement profiles through sqlite3_trace_v2. Statements are grouped by their
+// unexpanded SQL text so every execution of the same query lands in the same profile.
+// The sqlite3_stmt_status counters of traced statements are reset after each execution.
+// Times are the ones SQLite reports when a statement finishes, their resolution is that of
+// the VFS clock, which is a millisecond for the built-in ones.
+struct profiler {
+    enum flags : unsigned {
+        none = 0,
+        // counts rows as well, which costs a callback per row
+        rows = 1
+    };
+
+    profiler(sqlite3* db, unsigned options): db(db), options(options) {
+        unsigned mask = SQLITE_TRACE_PROFILE;
+        if(options & rows) {
+            mask |= SQLITE_TRACE_ROW;
+        }
+
+        int ret = sqlite3_trace_v2(db, mask, &profiler::callback, this);
+        if(ret != SQLITE_OK) {
+            throw error(ret);
+        }
+    }
+
+    profiler(const profiler&) = delete;
+    profiler& operator=(const profiler&) = delete;
+
+    ~profiler() {
+        sqlite3_trace_v2(db, 0, nullptr, nullptr);
+    }
+
+    std::vector<statement_profile> snapshot() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return { profiles.begin(), profiles.end() };
+    }
+
+    unsigned flags_in_use() const noexcept {
+        return options;
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        lookup.clear();
+        profiles.clear();
+    }
+private:
+    static int callback(unsigned type, void* context, void* p, void* x) noexcept {
+        auto self = static_cast<profiler*>(context);
+        auto stmt = static_cast<sqlite3_stmt*>(p);
+        try {
+            if(type == SQLITE_TRACE_PROFILE) {
+                self->record(stmt, *static_cast<sqlite3_int64*>(x), self->take_rows(stmt));
+            }
+            else if(type == SQLITE_TRACE_ROW) {
+                self->count_row(stmt);
+            }
+        }
+        catch(...) {
+            // nothing sensible to do from inside SQLite
+        }
+        return 0;
+    }
+
+    // SQLite only calls back from whichever thread is using the connection, so rows are counted
+    // without locking and added to the profile once the statement finishes. There are rarely
+    // more than a couple of statements stepping at once so a flat list is enough.
+    void count_row(sqlite3_stmt* stmt) {
+        for(auto it = pending_rows.rbegin(); it != pending_rows.rend(); ++it) {
+            if(it->first == stmt) {
+                ++it->second;
+                return;
+            }
+        }
+        pending_rows.emplace_back(stmt, 1);
+    }
+
+    uint64_t take_rows(sqlite3_stmt* stmt) noexcept {
+        for(auto&& entry : pending_rows) {
+            if(entry.first == stmt) {
+                auto count = entry.second;
+                entry = pending_rows.back();
+                pending_rows.pop_back();
+                return count;
+            }
+        }
+        return 0;
+    }
+
+    void record(sqlite3_stmt* stmt, sqlite3_int64 elapsed, uint64_t rows) {
+        auto fullscan = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1);
+        auto sort = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_SORT, 1);
+        auto autoindex = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_AUTOINDEX, 1);
+        auto vm_step = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_VM_STEP, 1);
+        auto reprepare = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_REPREPARE, 1);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        std::chrono::nanoseconds time(elapsed);
+
+        size_t bucket = 0;
+        for(auto n = static_cast<uint64_t>(time.count()); n != 0 && bucket + 1 < statement_profile::histogram_size; n >>= 1) {
+            ++bucket;
+        }
+
+        auto&& profile = find(stmt);
+        ++profile.calls;
+        profile.rows += rows;
+        profile.total_time += time;
+        if(time > profile.max_time) {
+            profile.max_time = time;
+        }
+        ++profile.histogram[bucket];
+        profile.fullscan_steps += fullscan;
+        profile.sorts += sort;
+        profile.autoindexes += autoindex;
+        profile.vm_steps += vm_step;
+        profile.reprepares += reprepare;
+    }
+
+    statement_profile& find(sqlite3_stmt* stmt) {
+        const char* sql = sqlite3_sql(stmt);
+        if(sql == nullptr) {
+            sql = "";
+        }
+
+        detail::sql_key key{ sql, std::char_traits<char>::length(sql) };
+        auto it = lookup.find(key);
+        if(it != lookup.end()) {
+            return *it->second;
+        }
+
+        profiles.emplace_back();
+        auto&& profile = profiles.back();
+        profile.sql.assign(key.data, key.size);
+        lookup.emplace(detail::sql_key{ profile.sql.data(), profile.sql.size() }, &profile);
+        return profile;
+    }
+
+    sqlite3* db;
+    unsigned options;
+    mutable std::mutex mutex;
+    std::list<statement_profile> profiles;
+    std::unordered_map<detail::sql_key, statement_profile*, detail::sql_key_hash> lookup;
+    std::vector<std::pair<sqlite3_stmt*, uint64_t>> pending_rows;
+};
+} // sqlite
@@ -0,0 +1,208 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <sqlitexx/type_traits.hpp>
+#include <sqlitexx/error.hpp>
+#include <sqlitexx/statement.hpp>
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <sqlite3.h>
+
+namespace sqlite {
+// A failure inside a script along with where it happened.
+struct script_error : error {
+    script_error(int ec, std::string msg, size_t offset, size_t index): error(ec), msg(std::move(msg)), off(offset), idx(index) {}
+
+    const char* message() const noexcept {
+        return msg.c_str();
+    }
+
+    // byte offset into the script, this points at the offending token when SQLite knows it
+    // and at the start of the failing statement otherwise
+    size_t offset() const noexcept {
+        return off;
+    }
+
+    // zero based index of the failing statement, not counting empty ones
+    size_t statement_index() const noexcept {
+        return idx;
+    }
+private:
+    std::string msg;
+    size_t off;
+    size_t idx;
+};
+
+namespace detail {
+// skips whitespace, semicolons and comments, i.e. everything prepare treats as an empty statement
+inline const char* skip_trivia(const char* first, const char* last) noexcept {
+    while(first != last) {
+        char c = *first;
+        if(c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == ';') {
+            ++first;
+        }
+        else if(c == '-' && last - first > 1 && first[1] == '-') {
+            while(first != last && *first != '\n') {
+                ++first;
+            }
+        }
+        else if(c == '/' && last - first > 1 && first[1] == '*') {
+            first += 2;
+            while(first != last && !(*first == '*' && last - first > 1 && first[1] == '/')) {
+                ++first;
+            }
+            first = first == last ? last : first + 2;
+        }
+        else {
+            break;
+        }
+    }
+    return first;
+}
+} // detail
+
+// Walks a buffer of SQL statements with prepare and its tail pointer, one statement at a time.
+// Each statement is only prepared after the previous one has run, so later statements can
+// refer to tables created earlier in the same script. The buffer is referenced, not copied.
+struct script {
+    script(sqlite3* db, const char* sql, size_t size) noexcept: db(db), first(sql), position(sql), last(sql + size),
+                                                                  current_stmt(empty()) {}
+
+    template<typename String>
+    script(sqlite3* db, const String& sql) noexcept:
+        script(db, meta::string_traits<String>::data(sql), meta::string_traits<String>::size(sql)) {}
+
+    // prepares the next non-empty statement, returns false once the script is exhausted
+    bool next() {
+        current_stmt = empty();
+        position = detail::skip_trivia(position, last);
+        while(position != last) {
+            const char* tail = nullptr;
+            sqlite3_stmt* ptr = nullptr;
+            try {
+                ptr = detail::prepare(db, position, static_cast<int>(last - position), 0, &tail);
+            }
+            catch(const error& e) {
+                throw failure(e.code(), error_offset());
+            }
+
+            if(ptr == nullptr && tail == position) {
+                break;
+            }
+
+            start = position;
+            position = detail::skip_trivia(tail, last);
+            if(ptr != nullptr) {
+                current_stmt = statement(ptr, nullptr);
+                ++count;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // the statement prepared by the last successful call to next
+    statement& current() noexcept {
+        return current_stmt;
+    }
+
+    // true if the current statement is the last one in the script
+    bool is_last() const noexcept {
+        return position == last;
+    }
+
+    // byte offset of the current statement from the start of the script
+    size_t offset() const noexcept {
+        return static_cast<size_t>(start - first);
+    }
+
+    size_t index() const noexcept {
+        return count - 1;
+    }
+
+    // steps the current statement until it's done, discarding any rows
+    void run() {
+        auto ptr = current_stmt.data();
+        int ret;
+        while((ret = sqlite3_step(ptr)) == SQLITE_ROW) {}
+        if(ret != SQLITE_DONE) {
+            throw failure(ret, 0);
+        }
+        sqlite3_reset(ptr);
+    }
+
+    // runs every statement left in the script, binding each of the named parameters the statement uses
+    template<typename... Binding>
+    void run_all(const Binding&... binds) {
+        while(next()) {
+            bind_available(binds...);
+            run();
+        }
+    }
+
+    // binds the named parameters the current statement refers to and skips the rest
+    template<typename... Binding>
+    void bind_available(const Binding&... binds) {
+        try {
+            using dummy = int[];
+            (void)dummy{ 0, (current_stmt.bind_to(binds.name(), binds.get()), 0)... };
+        }
+        catch(const error& e) {
+            throw failure(e.code(), 0);
+        }
+    }
+private:
+    static statement empty() noexcept {
+        return { static_cast<sqlite3_stmt*>(nullptr), nullptr };
+    }
+
+    int error_offset() const noexcept {
+#if SQLITE_VERSION_NUMBER >= 3038000
+        int ret = sqlite3_error_offset(db);
+        return ret < 0 ? 0 : ret;
+#else
+        return 0;
+#endif
+    }
+
+    // errors from prepare happen before start is updated so they are relative to position
+    script_error failure(int ec, int relative) const {
+        bool preparing = current_stmt.data() == nullptr;
+        auto base = preparing ? position : start;
+        size_t index = preparing ? count : count - 1;
+        return { ec, sqlite3_errmsg(db), static_cast<size_t>(base - first) + static_cast<size_t>(relative), index };
+    }
+
+    sqlite3* db;
+    const char* first;
+    const char* position;
+    const char* last;
+    const char* start = nullptr;
+    size_t count = 0;
+    statement current_stmt;
+};
+} // sqlite
@@ -0,0 +1,181 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <sqlitexx/type_traits.hpp>
+#include <sqlitexx/error.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <sqlite3.h>
+
+#if !defined(SQLITEXX_HAS_SERIALIZE)
+#if !defined(SQLITE_OMIT_DESERIALIZE) && (SQLITE_VERSION_NUMBER >= 3036000 || (SQLITE_VERSION_NUMBER >= 3023000 && defined(SQLITE_ENABLE_DESERIALIZE)))
+#define SQLITEXX_HAS_SERIALIZE 1
+#endif
+#endif
+
+#if !defined(SQLITEXX_HAS_MMAP) && (defined(__unix__) || defined(__APPLE__))
+#define SQLITEXX_HAS_MMAP 1
+#endif
+
+#if SQLITEXX_HAS_MMAP
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if SQLITEXX_HAS_SERIALIZE
+namespace sqlite {
+// A copy of a database as it would be stored on disk, allocated with sqlite3_malloc.
+// It can be written out as is or handed back to connection::deserialize without copying.
+struct serialized_database {
+    serialized_database() noexcept = default;
+
+    serialized_database(serialized_database&& o) noexcept: buffer(std::move(o.buffer)), length(o.length) {
+        o.length = 0;
+    }
+
+    serialized_database& operator=(serialized_database&& o) noexcept {
+        buffer = std::move(o.buffer);
+        length = o.length;
+        o.length = 0;
+        return *this;
+    }
+
+    const unsigned char* data() const noexcept {
+        return buffer.get();
+    }
+
+    size_t size() const noexcept {
+        return length;
+    }
+
+    bool empty() const noexcept {
+        return length == 0;
+    }
+
+    // gives up ownership, the buffer must be freed with sqlite3_free
+    unsigned char* release() noexcept {
+        length = 0;
+        return buffer.release();
+    }
+private:
+    friend struct connection;
+
+    serialized_database(unsigned char* ptr, size_t size) noexcept: buffer(ptr), length(size) {}
+
+    struct deleter {
+        void operator()(unsigned char* ptr) const noexcept {
+            sqlite3_free(ptr);
+        }
+    };
+
+    std::unique_ptr<unsigned char, deleter> buffer;
+    size_t length = 0;
+};
+
+#if SQLITEXX_HAS_MMAP
+// A database file mapped into memory for connection::deserialize_view. Pages are only read from
+// disk when they're first touched. The mapping is private, so the one page deserialize_view
+// may patch never makes it back to the file.
+struct mapped_file {
+    template<typename String>
+    explicit mapped_file(const String& filename) {
+        int fd = ::open(meta::string_traits<String>::c_str(filename), O_RDONLY | O_CLOEXEC);
+        if(fd == -1) {
+            throw error(SQLITE_CANTOPEN);
+        }
+
+        struct stat info;
+        if(::fstat(fd, &info) == -1) {
+            ::close(fd);
+            throw error(SQLITE_IOERR_FSTAT);
+        }
+
+        length = static_cast<size_t>(info.st_size);
+        if(length != 0) {
+            void* ptr = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if(ptr == MAP_FAILED) {
+                ::close(fd);
+                throw error(errno == ENOMEM ? SQLITE_NOMEM : SQLITE_IOERR_MMAP);
+            }
+            address = static_cast<unsigned char*>(ptr);
+        }
+        ::close(fd);
+    }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    ~mapped_file() {
+        if(address != nullptr) {
+            ::munmap(address, length);
+        }
+    }
+
+    unsigned char* data() const noexcept {
+        return address;
+    }
+
+    size_t size() const noexcept {
+        return length;
+    }
+
+    // hints that the whole file is about to be read, e.g. right before a full scan
+    void prefetch() const noexcept {
+        if(address != nullptr) {
+            ::madvise(address, length, MADV_WILLNEED);
+        }
+    }
+private:
+    unsigned char* address = nullptr;
+    size_t length = 0;
+};
+#endif
+
+namespace detail {
+// Bytes 18 and 19 of the header are 2 for WAL databases, which the in-memory VFS
+// behind deserialize can't open, so such images are switched back to rollback mode.
+inline void clear_wal_flag(unsigned char* image, size_t size) noexcept {
+    if(size >= 100 && image[18] == 2 && image[19] == 2) {
+        image[18] = 1;
+        image[19] = 1;
+    }
+}
+
+inline void deserialize(sqlite3* db, const char* schema, unsigned char* image, size_t size, size_t capacity, unsigned flags) {
+    clear_wal_flag(image, size);
+    int ret = sqlite3_deserialize(db, schema, image, static_cast<sqlite3_int64>(size), static_cast<sqlite3_int64>(capacity), flags);
+    if(ret != SQLITE_OK) {
+        throw error(ret);
+    }
+}
+} // detail
+} // sqlite
+#endif
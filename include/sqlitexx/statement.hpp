@@ -25,9 +25,14 @@
 #include <sqlitexx/type_traits.hpp>
 #include <sqlitexx/error.hpp>
 #include <sqlitexx/column.hpp>
+#include <sqlitexx/mapping.hpp>
 #include <sqlite3.h>
+#include <array>
+#include <cstring>
 #include <iterator>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace sqlite {
 struct blob {
@@ -35,13 +40,22 @@ struct blob {
     int length;
 };
 
+// binds a blob of the given size filled with zeroes, usually to be written to later through a blob_stream
+struct zeroblob {
+    sqlite3_uint64 size;
+};
+
 template<typename String, typename T>
 struct named_parameter {
     template<typename X, typename = std::enable_if_t<std::is_convertible<T, X>::value>>
     named_parameter(const String& name, X&& value): _name(name), value(std::forward<X>(value)) {}
 
-    T get() const& noexcept {
-        return std::move(value);
+    T get() const& {
+        return value;
+    }
+
+    T get() && noexcept {
+        return std::forward<T>(value);
     }
 
     const String& name() const noexcept {
@@ -52,6 +66,15 @@ private:
     T value;
 };
 
+// A named parameter resolved to its index ahead of time so binding to it is a direct index write.
+struct param_slot {
+    int index = 0;
+
+    explicit operator bool() const noexcept {
+        return index != 0;
+    }
+};
+
 template<typename>
 struct is_named_parameter : std::false_type {};
 
@@ -63,8 +86,42 @@ inline named_parameter<String, T> named(const String& name, T&& value) {
     return { name, std::forward<T>(value) };
 }
 
+// Binds a text or blob value with SQLITE_STATIC so SQLite doesn't copy it.
+// The referenced data must stay alive and unchanged until the statement is reset, re-bound or finalized.
+template<typename T>
+struct static_binding {
+    const T& value;
+};
+
+template<typename T>
+inline static_binding<T> bind_static(const T& value) noexcept {
+    return { value };
+}
+
 namespace meta {
 template<>
+struct bind_traits<blob> {
+    static int bind(sqlite3_stmt* ptr, int index, const blob& value, sqlite3_destructor_type lifetime = SQLITE_TRANSIENT) noexcept {
+        return sqlite3_bind_blob(ptr, index, value.data, value.length, lifetime);
+    }
+};
+
+template<>
+struct bind_traits<zeroblob> {
+    static int bind(sqlite3_stmt* ptr, int index, const zeroblob& value) noexcept {
+        return sqlite3_bind_zeroblob64(ptr, index, value.size);
+    }
+};
+
+template<typename T>
+struct bind_traits<static_binding<T>> {
+    static int bind(sqlite3_stmt* ptr, int index, const static_binding<T>& binding) noexcept {
+        return bind_traits<unqualified_t<T>>::bind(ptr, index, binding.value, SQLITE_STATIC);
+    }
+};
+
+// only valid until the statement is stepped, reset or finalized
+template<>
 struct column_traits<blob> {
     static blob convert(sqlite3_stmt* ptr, int index) noexcept {
         return {
@@ -75,9 +132,45 @@ struct column_traits<blob> {
 };
 } // meta
 
+// defined in sqlitexx/dynamic.hpp
+struct dynamic_row;
+
 namespace detail {
 struct end_tag {};
 
+// something that takes a statement back instead of it being finalized
+struct statement_owner {
+    virtual void release(sqlite3_stmt* ptr) noexcept = 0;
+protected:
+    ~statement_owner() = default;
+};
+
+inline sqlite3_stmt* prepare(sqlite3* db, const char* sql, int size, unsigned flags, const char** tail = nullptr) {
+    sqlite3_stmt* ptr = nullptr;
+#if SQLITE_VERSION_NUMBER >= 3020000
+    int ret = sqlite3_prepare_v3(db, sql, size, flags, &ptr, tail);
+#else
+    (void)flags;
+    int ret = sqlite3_prepare_v2(db, sql, size, &ptr, tail);
+#endif
+    if(ret != SQLITE_OK) {
+        throw error(ret);
+    }
+    return ptr;
+}
+
+// a table or column name as a quoted identifier for SQL built at runtime
+inline std::string quote_identifier(const std::string& name) {
+    std::string result = "\"";
+    for(char c : name) {
+        result += c;
+        if(c == '"') {
+            result += '"';
+        }
+    }
+    return result += '"';
+}
+
 template<typename... Args>
 struct statement_iterator {
     using difference_type = std::ptrdiff_t;
@@ -145,6 +238,18 @@ private:
     }
 };
 
+// defined in sqlitexx/batch.hpp
+template<typename Pointer, typename... Args>
+struct batch_reader;
+
+// defined in sqlitexx/pipeline.hpp
+template<typename Pointer, typename... Args>
+struct pipelined_range;
+
+// defined in sqlitexx/dynamic.hpp
+template<typename Pointer>
+struct dynamic_range;
+
 template<typename Pointer, typename... Args>
 struct statement_range {
     using iterator = statement_iterator<Args...>;
@@ -166,6 +271,65 @@ struct statement_range {
         }
     }
 };
+// a single mapped struct fetches into that struct instead of a column proxy
+template<typename Pointer, typename... Args>
+struct select_range {
+    using type = statement_range<Pointer, Args...>;
+};
+
+template<typename Pointer, typename T>
+struct select_range<Pointer, T> {
+    using type = std::conditional_t<meta::is_mapped<meta::unqualified_t<T>>::value,
+                                    mapped_range<Pointer, meta::unqualified_t<T>>,
+                                    statement_range<Pointer, T>>;
+};
+
+template<typename Pointer>
+struct select_range<Pointer, dynamic_row> {
+    using type = dynamic_range<Pointer>;
+};
+
+// the lazy ranges returned by the fetch family, which step their statement while being iterated
+template<typename T>
+struct is_statement_range : std::false_type {};
+
+template<typename Pointer, typename... Args>
+struct is_statement_range<statement_range<Pointer, Args...>> : std::true_type {};
+
+template<typename Pointer, typename T>
+struct is_statement_range<mapped_range<Pointer, T>> : std::true_type {};
+
+template<typename Pointer>
+struct is_statement_range<dynamic_range<Pointer>> : std::true_type {};
+
+template<typename Pointer, typename... Args>
+struct is_statement_range<batch_reader<Pointer, Args...>> : std::true_type {};
+
+template<typename Pointer, typename... Args>
+struct is_statement_range<pipelined_range<Pointer, Args...>> : std::true_type {};
+
+struct mapped_tag {};
+
+// a unique address per mapped type to tell which one the cached parameter indices belong to
+template<typename T>
+struct mapped_key {
+    static const char id;
+};
+
+template<typename T>
+const char mapped_key<T>::id = 0;
+
+template<typename... Args>
+struct bind_tag {
+    using type = meta::and_<is_named_parameter<meta::unqualified_t<Args>>...>;
+};
+
+template<typename T>
+struct bind_tag<T> {
+    using type = std::conditional_t<meta::is_mapped<meta::unqualified_t<T>>::value,
+                                    mapped_tag,
+                                    is_named_parameter<meta::unqualified_t<T>>>;
+};
 } // detail
 
 struct statement {
@@ -177,6 +341,13 @@ struct statement {
         }
     }
 
+    template<typename T>
+    void bind_to(param_slot slot, T&& value) const {
+        bind_to(slot.index, std::forward<T>(value));
+    }
+
+    // looks the name up on every call and ignores names that don't exist,
+    // prefer resolving a param_slot once through slot() for repeated binds
     template<typename String, typename T>
     void bind_to(const String& name, T&& value) const {
         int index = sqlite3_bind_parameter_index(_ptr.get(), meta::string_traits<String>::c_str(name));
@@ -188,9 +359,35 @@ struct statement {
         bind_to(index, std::forward<T>(value));
     }
 
+    // resolves a parameter name including its prefix, e.g. ":id", throwing if there is no such parameter
+    template<typename String>
+    param_slot slot(const String& name) const {
+        auto result = find_slot(name);
+        if(!result) {
+            throw error(SQLITE_RANGE);
+        }
+        return result;
+    }
+
+    // same as slot but returns an empty slot if the parameter doesn't exist
+    template<typename String>
+    param_slot find_slot(const String& name) const noexcept {
+        return { sqlite3_bind_parameter_index(_ptr.get(), meta::string_traits<String>::c_str(name)) };
+    }
+
+    // resolves several names at once, e.g. auto plan = stmt.slots(":id", ":name");
+    template<typename... Strings>
+    std::array<param_slot, sizeof...(Strings)> slots(const Strings&... names) const {
+        return {{ slot(names)... }};
+    }
+
     template<typename... Args>
     void bind(Args&&... args) const {
-        bind_impl(meta::and_<is_named_parameter<meta::unqualified_t<Args>>...>{}, std::forward<Args>(args)...);
+        bind_impl(typename detail::bind_tag<Args...>::type{}, std::forward<Args>(args)...);
+    }
+
+    sqlite3_stmt* data() const noexcept {
+        return _ptr.get();
     }
 
     int count() const noexcept {
@@ -228,15 +425,48 @@ struct statement {
 
     template<typename... Args>
     auto fetch() const& {
-        return detail::statement_range<const decltype(_ptr)&, Args...>{_ptr};
+        return typename detail::select_range<const decltype(_ptr)&, Args...>::type{_ptr};
     }
 
     template<typename... Args>
     auto fetch() && {
-        return detail::statement_range<decltype(_ptr), Args...>{std::move(_ptr)};
+        return typename detail::select_range<decltype(_ptr), Args...>::type{std::move(_ptr)};
+    }
+
+    // decodes rows into column_batch<Args...> objects holding up to rows_per_batch rows each,
+    // throws SQLITE_MISUSE if rows_per_batch is 0
+    template<typename... Args>
+    auto fetch_batches(size_t rows_per_batch) const& {
+        check_batch_size(rows_per_batch);
+        return detail::batch_reader<const decltype(_ptr)&, Args...>{_ptr, rows_per_batch};
+    }
+
+    template<typename... Args>
+    auto fetch_batches(size_t rows_per_batch) && {
+        check_batch_size(rows_per_batch);
+        return detail::batch_reader<decltype(_ptr), Args...>{std::move(_ptr), rows_per_batch};
+    }
+
+    // steps and decodes on a background thread into a ring of capacity rows, see pipelined_range
+    template<typename... Args>
+    auto fetch_pipelined(size_t capacity = 256) const& {
+        return detail::pipelined_range<const decltype(_ptr)&, Args...>{_ptr, capacity};
+    }
+
+    template<typename... Args>
+    auto fetch_pipelined(size_t capacity = 256) && {
+        return detail::pipelined_range<decltype(_ptr), Args...>{std::move(_ptr), capacity};
     }
 private:
     friend struct connection;
+    friend struct statement_cache;
+    friend struct script;
+
+    static void check_batch_size(size_t rows) {
+        if(rows == 0) {
+            throw error(SQLITE_MISUSE);
+        }
+    }
 
     template<typename... Args>
     void bind_impl(std::true_type, Args&&... args) const {
@@ -249,21 +479,77 @@ private:
         bind_parameters(std::index_sequence_for<Args...>{}, std::forward<Args>(args)...);
     }
 
-    template<typename String>
-    statement(sqlite3* db, const String& statement) {
-        using Traits = meta::string_traits<String>;
-        auto ptr = _ptr.get();
-        int ret = sqlite3_prepare_v2(db, Traits::c_str(statement), Traits::size(statement), &ptr, nullptr);
-        if(ret != SQLITE_OK) {
-            throw error(ret);
+    // Binds by :name when the statement uses named parameters, otherwise by field order.
+    // The parameter of every field is looked up on the first bind of a T and reused afterwards.
+    template<typename T>
+    void bind_impl(detail::mapped_tag, const T& value) const {
+        constexpr auto fields = row_mapping<T>::fields();
+        constexpr auto indices = std::make_index_sequence<meta::field_count<T>::value>{};
+        if(mapped_type != &detail::mapped_key<T>::id) {
+            mapped_type = nullptr;
+            resolve_fields(fields, indices);
+            mapped_type = &detail::mapped_key<T>::id;
         }
+        bind_fields(value, fields, indices);
+    }
 
-        _ptr.reset(ptr);
+    template<typename Fields, size_t... I>
+    void resolve_fields(const Fields& fields, std::index_sequence<I...>) const {
+        bool named = count() > 0 && is_named(1);
+        mapped_slots.clear();
+        using dummy = int[];
+        (void)dummy{ 0, (mapped_slots.push_back(resolve_field(named, std::get<I>(fields).name, static_cast<int>(I + 1))), 0)... };
+    }
+
+    // a field without a parameter is most likely a typo in row_mapping so it's an error like in slot
+    int resolve_field(bool named, const char* name, int position) const {
+        int index = named ? parameter_index(name) : position;
+        if(index == 0 || index > count()) {
+            throw error(SQLITE_RANGE);
+        }
+        return index;
+    }
+
+    template<typename T, typename Fields, size_t... I>
+    void bind_fields(const T& value, const Fields& fields, std::index_sequence<I...>) const {
+        using dummy = int[];
+        (void)dummy{ 0, (bind_to(mapped_slots[I], value.*(std::get<I>(fields).member)), 0)... };
     }
 
+    bool is_named(int index) const noexcept {
+        auto name = sqlite3_bind_parameter_name(_ptr.get(), index);
+        return name != nullptr && name[0] != '?';
+    }
+
+    // finds a parameter by name regardless of its :, @ or $ prefix
+    int parameter_index(const char* name) const noexcept {
+        for(int i = 1, n = count(); i <= n; ++i) {
+            auto param = sqlite3_bind_parameter_name(_ptr.get(), i);
+            if(param != nullptr && param[0] != '?' && std::strcmp(param + 1, name) == 0) {
+                return i;
+            }
+        }
+        return 0;
+    }
+
+    template<typename String>
+    statement(sqlite3* db, const String& statement, unsigned flags = 0) {
+        using Traits = meta::string_traits<String>;
+        _ptr.reset(detail::prepare(db, Traits::data(statement), Traits::size(statement), flags));
+    }
+
+    statement(sqlite3_stmt* ptr, detail::statement_owner* owner) noexcept: _ptr(ptr, deleter{owner}) {}
+
     struct deleter {
+        detail::statement_owner* owner; // null unless the statement came from a cache
+
         void operator()(sqlite3_stmt* ptr) const noexcept {
-            sqlite3_finalize(ptr);
+            if(owner) {
+                owner->release(ptr);
+            }
+            else {
+                sqlite3_finalize(ptr);
+            }
         }
     };
 
@@ -274,5 +560,8 @@ private:
     }
 
     std::unique_ptr<sqlite3_stmt, deleter> _ptr;
+    // parameter index of every field of the last mapped struct type bound, see bind_impl
+    mutable std::vector<int> mapped_slots;
+    mutable const void* mapped_type = nullptr;
 };
 } // sqlite
@@ -28,6 +28,16 @@
 #include <utility>
 #include <sqlite3.h>
 
+#if !defined(SQLITEXX_HAS_STRING_VIEW) && defined(__has_include)
+#if __has_include(<string_view>) && (__cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L))
+#define SQLITEXX_HAS_STRING_VIEW 1
+#endif
+#endif
+
+#if SQLITEXX_HAS_STRING_VIEW
+#include <string_view>
+#endif
+
 namespace sqlite {
 namespace meta {
 template<typename...>
@@ -91,6 +101,10 @@ struct string_traits<std::basic_string<char, Rest...>> {
         return str.c_str();
     }
 
+    static const char* data(const std::basic_string<char, Rest...>& str) noexcept {
+        return str.data();
+    }
+
     static size_t size(const std::basic_string<char, Rest...>& str) noexcept {
         return str.size();
     }
@@ -102,6 +116,10 @@ struct string_traits<char[N]> {
         return arr;
     }
 
+    static const char* data(const char (&arr)[N]) noexcept {
+        return arr;
+    }
+
     static size_t size(const char (&)[N]) noexcept {
         return N - 1;
     }
@@ -113,10 +131,42 @@ struct string_traits<const char*> {
         return str;
     }
 
+    static const char* data(const char* str) noexcept {
+        return str;
+    }
+
     static size_t size(const char* str) noexcept {
         return std::char_traits<char>::length(str);
     }
 };
+
+#if SQLITEXX_HAS_STRING_VIEW
+// a null terminated copy of a view that lasts until the end of the full expression
+// it was made in, which is as long as the SQLite calls taking a name or a query need it
+struct terminated_view {
+    std::string str;
+
+    operator const char*() const noexcept {
+        return str.c_str();
+    }
+};
+
+// a view isn't guaranteed to be null terminated so c_str copies it, data and size don't
+template<typename Traits>
+struct string_traits<std::basic_string_view<char, Traits>> {
+    static terminated_view c_str(std::basic_string_view<char, Traits> str) {
+        return { std::string(str.data(), str.size()) };
+    }
+
+    static const char* data(std::basic_string_view<char, Traits> str) noexcept {
+        return str.data();
+    }
+
+    static size_t size(std::basic_string_view<char, Traits> str) noexcept {
+        return str.size();
+    }
+};
+#endif
 } // detail
 
 template<typename T>
@@ -187,14 +237,15 @@ struct bind_traits<decltype(nullptr)> {
     }
 };
 
+// text bindings take an optional destructor, SQLITE_STATIC skips SQLite's copy of the data
 template<typename T, unsigned N>
 struct bind_traits<T[N], std::enable_if_t<is_any_of<T, char, char16_t>::value>> {
-    static int bind(sqlite3_stmt* ptr, int index, const char* str) noexcept {
-        return sqlite3_bind_text(ptr, index, str, N * sizeof(char) - 1, SQLITE_STATIC);
+    static int bind(sqlite3_stmt* ptr, int index, const char* str, sqlite3_destructor_type lifetime = SQLITE_STATIC) noexcept {
+        return sqlite3_bind_text(ptr, index, str, N * sizeof(char) - 1, lifetime);
     }
 
-    static int bind(sqlite3_stmt* ptr, int index, const char16_t* str) noexcept {
-        return sqlite3_bind_text16(ptr, index, str, N * sizeof(char16_t) - 1, SQLITE_STATIC);
+    static int bind(sqlite3_stmt* ptr, int index, const char16_t* str, sqlite3_destructor_type lifetime = SQLITE_STATIC) noexcept {
+        return sqlite3_bind_text16(ptr, index, str, N * sizeof(char16_t) - 1, lifetime);
     }
 };
 
@@ -202,25 +253,45 @@ template<typename T>
 struct bind_traits<const T*, std::enable_if_t<is_any_of<T, char, char16_t>::value>> {
     using Traits = std::char_traits<T>;
 
-    static int bind(sqlite3_stmt* ptr, int index, const char* str) noexcept {
-        return sqlite3_bind_text(ptr, index, str, Traits::length(str), SQLITE_TRANSIENT);
+    static int bind(sqlite3_stmt* ptr, int index, const char* str, sqlite3_destructor_type lifetime = SQLITE_TRANSIENT) noexcept {
+        return sqlite3_bind_text(ptr, index, str, Traits::length(str), lifetime);
     }
 
-    static int bind(sqlite3_stmt* ptr, int index, const char16_t* str) noexcept {
-        return sqlite3_bind_text16(ptr, index, str, Traits::length(str) * sizeof(char16_t), SQLITE_TRANSIENT);
+    static int bind(sqlite3_stmt* ptr, int index, const char16_t* str, sqlite3_destructor_type lifetime = SQLITE_TRANSIENT) noexcept {
+        return sqlite3_bind_text16(ptr, index, str, Traits::length(str) * sizeof(char16_t), lifetime);
     }
 };
 
 template<typename CharT, typename... Rest>
 struct bind_traits<std::basic_string<CharT, Rest...>, std::enable_if_t<is_any_of<CharT, char, char16_t>::value>> {
-    static int bind(sqlite3_stmt* ptr, int index, const std::basic_string<char, Rest...>& str) noexcept {
-        return sqlite3_bind_text(ptr, index, str.c_str(), str.size(), SQLITE_TRANSIENT);
+    static int bind(sqlite3_stmt* ptr, int index, const std::basic_string<char, Rest...>& str,
+                    sqlite3_destructor_type lifetime = SQLITE_TRANSIENT) noexcept {
+        return sqlite3_bind_text(ptr, index, str.c_str(), str.size(), lifetime);
+    }
+
+    static int bind(sqlite3_stmt* ptr, int index, const std::basic_string<char16_t, Rest...>& str,
+                    sqlite3_destructor_type lifetime = SQLITE_TRANSIENT) noexcept {
+        return sqlite3_bind_text16(ptr, index, str.c_str(), str.size() * sizeof(char16_t), lifetime);
+    }
+};
+
+#if SQLITEXX_HAS_STRING_VIEW
+template<typename Traits>
+struct bind_traits<std::basic_string_view<char, Traits>> {
+    static int bind(sqlite3_stmt* ptr, int index, std::basic_string_view<char, Traits> str,
+                    sqlite3_destructor_type lifetime = SQLITE_TRANSIENT) noexcept {
+        return sqlite3_bind_text(ptr, index, str.data(), static_cast<int>(str.size()), lifetime);
     }
+};
 
-    static int bind(sqlite3_stmt* ptr, int index, const std::basic_string<char16_t, Rest...>& str) noexcept {
-        return sqlite3_bind_text16(ptr, index, str.c_str(), str.size() * sizeof(char16_t), SQLITE_TRANSIENT);
+template<typename Traits>
+struct bind_traits<std::basic_string_view<char16_t, Traits>> {
+    static int bind(sqlite3_stmt* ptr, int index, std::basic_string_view<char16_t, Traits> str,
+                    sqlite3_destructor_type lifetime = SQLITE_TRANSIENT) noexcept {
+        return sqlite3_bind_text16(ptr, index, str.data(), static_cast<int>(str.size() * sizeof(char16_t)), lifetime);
     }
 };
+#endif
 
 template<typename T, typename = void>
 struct column_traits;
@@ -276,6 +347,17 @@ struct column_traits<std::basic_string<char, Args...>> {
     }
 };
 
+#if SQLITEXX_HAS_STRING_VIEW
+// only valid until the statement is stepped, reset or finalized
+template<typename Traits>
+struct column_traits<std::basic_string_view<char, Traits>> {
+    static std::basic_string_view<char, Traits> convert(sqlite3_stmt* ptr, int index) noexcept {
+        auto str = reinterpret_cast<const char*>(sqlite3_column_text(ptr, index));
+        return { str, static_cast<size_t>(sqlite3_column_bytes(ptr, index)) };
+    }
+};
+#endif
+
 template<typename... Args>
 struct column_traits<std::basic_string<char16_t, Args...>> {
     using return_type = std::basic_string<char16_t, Args...>;
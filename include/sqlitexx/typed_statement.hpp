@@ -0,0 +1,111 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <sqlitexx/type_traits.hpp>
+#include <sqlitexx/error.hpp>
+#include <sqlitexx/statement.hpp>
+
+#include <type_traits>
+#include <utility>
+#include <sqlite3.h>
+
+namespace sqlite {
+// tags for spelling out typed_statement signatures, e.g.
+// typed_statement<params(long long), row(std::string, double)>
+struct params;
+struct row;
+
+namespace meta {
+// how a declared parameter type is passed to a typed statement
+template<typename T>
+using param_t = std::conditional_t<std::is_scalar<T>::value, T, const T&>;
+} // meta
+
+template<typename Params, typename Row>
+struct typed_statement;
+
+// A statement whose parameter and column types are fixed at compile time.
+// The parameter and column counts are checked once when it's created, so binding
+// is a straight run of bind calls with a single error check at the end.
+template<typename P, typename... Params, typename R, typename... Columns>
+struct typed_statement<P(Params...), R(Columns...)> {
+    static constexpr int parameter_count = static_cast<int>(sizeof...(Params));
+    static constexpr int column_count = static_cast<int>(sizeof...(Columns));
+
+    // throws SQLITE_RANGE if the statement doesn't match the signature
+    explicit typed_statement(statement stmt): stmt(std::move(stmt)) {
+        auto ptr = this->stmt.data();
+        if(sqlite3_bind_parameter_count(ptr) != parameter_count || sqlite3_column_count(ptr) != column_count) {
+            throw error(SQLITE_RANGE);
+        }
+    }
+
+    // runs the statement to completion, discarding any rows
+    void execute(meta::param_t<Params>... args) const {
+        auto ptr = prepare(args...);
+        int ret;
+        while((ret = sqlite3_step(ptr)) == SQLITE_ROW) {}
+        sqlite3_reset(ptr);
+        if(ret != SQLITE_DONE) {
+            throw error(ret);
+        }
+    }
+
+    // the rows are only valid until the statement is executed or fetched again
+    auto fetch(meta::param_t<Params>... args) const {
+        prepare(args...);
+        return stmt.template fetch<Columns...>();
+    }
+
+    sqlite3_stmt* data() const noexcept {
+        return stmt.data();
+    }
+
+    const statement& get() const noexcept {
+        return stmt;
+    }
+private:
+    sqlite3_stmt* prepare(meta::param_t<Params>... args) const {
+        auto ptr = stmt.data();
+        // a statement left mid-iteration by an earlier fetch refuses new bindings
+        sqlite3_reset(ptr);
+        bind(ptr, std::make_index_sequence<sizeof...(Params)>{}, args...);
+        return ptr;
+    }
+
+    template<size_t... I>
+    static void bind(sqlite3_stmt* ptr, std::index_sequence<I...>, meta::param_t<Params>... args) {
+        int ret = SQLITE_OK;
+        using dummy = int[];
+        (void)dummy{ 0, (ret |= meta::bind_traits<meta::unqualified_t<Params>>::bind(ptr, static_cast<int>(I + 1), args), 0)... };
+        if(ret != SQLITE_OK) {
+            // the individual codes were merged so ask the connection which one it was
+            throw error(sqlite3_errcode(sqlite3_db_handle(ptr)));
+        }
+    }
+
+    statement stmt;
+};
+} // sqlite
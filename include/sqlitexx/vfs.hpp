@@ -0,0 +1,736 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <sqlitexx/error.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sqlite3.h>
+
+namespace sqlite {
+namespace detail {
+inline int file_type(int flags) noexcept {
+    return flags & (SQLITE_OPEN_MAIN_DB | SQLITE_OPEN_TEMP_DB | SQLITE_OPEN_TRANSIENT_DB |
+                    SQLITE_OPEN_MAIN_JOURNAL | SQLITE_OPEN_TEMP_JOURNAL | SQLITE_OPEN_SUBJOURNAL |
+                    SQLITE_OPEN_MASTER_JOURNAL | SQLITE_OPEN_WAL);
+}
+} // detail
+
+// One file opened through a vfs_shim. Every method forwards to the file opened by the wrapped
+// VFS, so a shim derives from this and overrides only what it wants to intercept. The methods
+// mirror sqlite3_io_methods and report failures through SQLite result codes, anything thrown
+// out of them is turned into SQLITE_IOERR or SQLITE_NOMEM.
+struct vfs_file {
+    vfs_file(sqlite3_file* base, const char* name, int flags) noexcept: base(base), file_name(name), open_flags(flags) {}
+
+    vfs_file(const vfs_file&) = delete;
+    vfs_file& operator=(const vfs_file&) = delete;
+
+    virtual ~vfs_file() = default;
+
+    virtual int close() { return base->pMethods->xClose(base); }
+    virtual int read(void* buffer, int amount, sqlite3_int64 offset) { return base->pMethods->xRead(base, buffer, amount, offset); }
+    virtual int write(const void* buffer, int amount, sqlite3_int64 offset) { return base->pMethods->xWrite(base, buffer, amount, offset); }
+    virtual int truncate(sqlite3_int64 size) { return base->pMethods->xTruncate(base, size); }
+    virtual int sync(int flags) { return base->pMethods->xSync(base, flags); }
+    virtual int file_size(sqlite3_int64* size) { return base->pMethods->xFileSize(base, size); }
+    virtual int lock(int level) { return base->pMethods->xLock(base, level); }
+    virtual int unlock(int level) { return base->pMethods->xUnlock(base, level); }
+    virtual int check_reserved_lock(int* result) { return base->pMethods->xCheckReservedLock(base, result); }
+    virtual int file_control(int op, void* arg) { return base->pMethods->xFileControl(base, op, arg); }
+    virtual int sector_size() { return base->pMethods->xSectorSize(base); }
+    virtual int device_characteristics() { return base->pMethods->xDeviceCharacteristics(base); }
+
+    // only called when the wrapped file supports shared memory, i.e. version 2 of sqlite3_io_methods
+    virtual int shm_map(int region, int size, int extend, void volatile** out) { return base->pMethods->xShmMap(base, region, size, extend, out); }
+    virtual int shm_lock(int offset, int n, int flags) { return base->pMethods->xShmLock(base, offset, n, flags); }
+    virtual void shm_barrier() { base->pMethods->xShmBarrier(base); }
+    virtual int shm_unmap(int delete_flag) { return base->pMethods->xShmUnmap(base, delete_flag); }
+
+    // only called when the wrapped file supports memory mapping, i.e. version 3 of sqlite3_io_methods
+    virtual int fetch(sqlite3_int64 offset, int amount, void** out) { return base->pMethods->xFetch(base, offset, amount, out); }
+    virtual int unfetch(sqlite3_int64 offset, void* ptr) { return base->pMethods->xUnfetch(base, offset, ptr); }
+
+    sqlite3_file* underlying() const noexcept {
+        return base;
+    }
+
+    // null for temporary files
+    const char* name() const noexcept {
+        return file_name;
+    }
+
+    int flags() const noexcept {
+        return open_flags;
+    }
+
+    // what the file is used for, one of SQLITE_OPEN_MAIN_DB, SQLITE_OPEN_WAL, SQLITE_OPEN_MAIN_JOURNAL etc.
+    int type() const noexcept {
+        return detail::file_type(open_flags);
+    }
+protected:
+    sqlite3_file* base;
+    const char* file_name;
+    int open_flags;
+};
+
+namespace detail {
+// what SQLite sees as the sqlite3_file of a shim, the wrapped file lives right after it
+struct shim_handle {
+    sqlite3_file header;
+    vfs_file* file;
+};
+
+constexpr size_t shim_base_offset = (sizeof(shim_handle) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+template<typename F>
+inline int guarded_io(F&& f) noexcept {
+    try {
+        return f();
+    }
+    catch(const std::bad_alloc&) {
+        return SQLITE_NOMEM;
+    }
+    catch(...) {
+        return SQLITE_IOERR;
+    }
+}
+
+inline vfs_file& shim_file(sqlite3_file* file) noexcept {
+    return *reinterpret_cast<shim_handle*>(file)->file;
+}
+
+inline sqlite3_io_methods make_io_methods(int version) noexcept {
+    sqlite3_io_methods methods{};
+    methods.iVersion = version;
+    methods.xClose = [](sqlite3_file* f) {
+        auto handle = reinterpret_cast<shim_handle*>(f);
+        int ret = guarded_io([&] { return handle->file->close(); });
+        delete handle->file;
+        handle->file = nullptr;
+        return ret;
+    };
+    methods.xRead = [](sqlite3_file* f, void* buffer, int amount, sqlite3_int64 offset) {
+        return guarded_io([&] { return shim_file(f).read(buffer, amount, offset); });
+    };
+    methods.xWrite = [](sqlite3_file* f, const void* buffer, int amount, sqlite3_int64 offset) {
+        return guarded_io([&] { return shim_file(f).write(buffer, amount, offset); });
+    };
+    methods.xTruncate = [](sqlite3_file* f, sqlite3_int64 size) {
+        return guarded_io([&] { return shim_file(f).truncate(size); });
+    };
+    methods.xSync = [](sqlite3_file* f, int flags) {
+        return guarded_io([&] { return shim_file(f).sync(flags); });
+    };
+    methods.xFileSize = [](sqlite3_file* f, sqlite3_int64* size) {
+        return guarded_io([&] { return shim_file(f).file_size(size); });
+    };
+    methods.xLock = [](sqlite3_file* f, int level) {
+        return guarded_io([&] { return shim_file(f).lock(level); });
+    };
+    methods.xUnlock = [](sqlite3_file* f, int level) {
+        return guarded_io([&] { return shim_file(f).unlock(level); });
+    };
+    methods.xCheckReservedLock = [](sqlite3_file* f, int* result) {
+        return guarded_io([&] { return shim_file(f).check_reserved_lock(result); });
+    };
+    methods.xFileControl = [](sqlite3_file* f, int op, void* arg) {
+        return guarded_io([&] { return shim_file(f).file_control(op, arg); });
+    };
+    methods.xSectorSize = [](sqlite3_file* f) {
+        return guarded_io([&] { return shim_file(f).sector_size(); });
+    };
+    methods.xDeviceCharacteristics = [](sqlite3_file* f) {
+        return guarded_io([&] { return shim_file(f).device_characteristics(); });
+    };
+
+    if(version >= 2) {
+        methods.xShmMap = [](sqlite3_file* f, int region, int size, int extend, void volatile** out) {
+            return guarded_io([&] { return shim_file(f).shm_map(region, size, extend, out); });
+        };
+        methods.xShmLock = [](sqlite3_file* f, int offset, int n, int flags) {
+            return guarded_io([&] { return shim_file(f).shm_lock(offset, n, flags); });
+        };
+        methods.xShmBarrier = [](sqlite3_file* f) {
+            guarded_io([&] { shim_file(f).shm_barrier(); return SQLITE_OK; });
+        };
+        methods.xShmUnmap = [](sqlite3_file* f, int delete_flag) {
+            return guarded_io([&] { return shim_file(f).shm_unmap(delete_flag); });
+        };
+    }
+
+    if(version >= 3) {
+        methods.xFetch = [](sqlite3_file* f, sqlite3_int64 offset, int amount, void** out) {
+            return guarded_io([&] { return shim_file(f).fetch(offset, amount, out); });
+        };
+        methods.xUnfetch = [](sqlite3_file* f, sqlite3_int64 offset, void* ptr) {
+            return guarded_io([&] { return shim_file(f).unfetch(offset, ptr); });
+        };
+    }
+    return methods;
+}
+
+// the methods have to match the version of the wrapped file since SQLite checks it
+inline const sqlite3_io_methods* shim_io_methods(int version) noexcept {
+    static const sqlite3_io_methods methods[] = { make_io_methods(1), make_io_methods(2), make_io_methods(3) };
+    return &methods[std::min(std::max(version, 1), 3) - 1];
+}
+} // detail
+
+// A VFS that wraps another one, by default the default VFS, and hands every file it opens to
+// open_file so it can be intercepted through a vfs_file. The VFS is registered under name
+// from install() until uninstall() or destruction, connections select it by name (see
+// connection::open) and have to be closed before the shim is destroyed.
+// SQLite may call into the shim from any thread as soon as it's registered, so a derived shim
+// calls install() at the end of its constructor and uninstall() at the start of its destructor,
+// that way open_file never runs on a partially built or partially destroyed object.
+struct vfs_shim {
+    explicit vfs_shim(std::string name, const char* parent = nullptr): vfs_name(std::move(name)) {
+        base_vfs = sqlite3_vfs_find(parent);
+        if(base_vfs == nullptr) {
+            throw error(SQLITE_ERROR);
+        }
+
+        vfs.iVersion = std::min(base_vfs->iVersion, 3);
+        vfs.szOsFile = static_cast<int>(detail::shim_base_offset) + base_vfs->szOsFile;
+        vfs.mxPathname = base_vfs->mxPathname;
+        vfs.zName = vfs_name.c_str();
+        vfs.pAppData = this;
+        vfs.xOpen = &vfs_shim::open_callback;
+        vfs.xDelete = [](sqlite3_vfs* v, const char* name, int sync_dir) {
+            auto p = parent_of(v);
+            return p->xDelete(p, name, sync_dir);
+        };
+        vfs.xAccess = [](sqlite3_vfs* v, const char* name, int flags, int* result) {
+            auto p = parent_of(v);
+            return p->xAccess(p, name, flags, result);
+        };
+        vfs.xFullPathname = [](sqlite3_vfs* v, const char* name, int size, char* out) {
+            auto p = parent_of(v);
+            return p->xFullPathname(p, name, size, out);
+        };
+        if(base_vfs->xDlOpen != nullptr) {
+            vfs.xDlOpen = [](sqlite3_vfs* v, const char* name) {
+                auto p = parent_of(v);
+                return p->xDlOpen(p, name);
+            };
+            vfs.xDlError = [](sqlite3_vfs* v, int size, char* out) {
+                auto p = parent_of(v);
+                p->xDlError(p, size, out);
+            };
+            vfs.xDlSym = [](sqlite3_vfs* v, void* handle, const char* symbol) -> void (*)(void) {
+                auto p = parent_of(v);
+                return p->xDlSym(p, handle, symbol);
+            };
+            vfs.xDlClose = [](sqlite3_vfs* v, void* handle) {
+                auto p = parent_of(v);
+                p->xDlClose(p, handle);
+            };
+        }
+        vfs.xRandomness = [](sqlite3_vfs* v, int size, char* out) {
+            auto p = parent_of(v);
+            return p->xRandomness(p, size, out);
+        };
+        vfs.xSleep = [](sqlite3_vfs* v, int microseconds) {
+            auto p = parent_of(v);
+            return p->xSleep(p, microseconds);
+        };
+        vfs.xCurrentTime = [](sqlite3_vfs* v, double* out) {
+            auto p = parent_of(v);
+            return p->xCurrentTime(p, out);
+        };
+        vfs.xGetLastError = [](sqlite3_vfs* v, int size, char* out) {
+            auto p = parent_of(v);
+            return p->xGetLastError ? p->xGetLastError(p, size, out) : 0;
+        };
+        if(vfs.iVersion >= 2) {
+            vfs.xCurrentTimeInt64 = [](sqlite3_vfs* v, sqlite3_int64* out) {
+                auto p = parent_of(v);
+                return p->xCurrentTimeInt64(p, out);
+            };
+        }
+        if(vfs.iVersion >= 3) {
+            vfs.xSetSystemCall = [](sqlite3_vfs* v, const char* name, sqlite3_syscall_ptr call) {
+                auto p = parent_of(v);
+                return p->xSetSystemCall(p, name, call);
+            };
+            vfs.xGetSystemCall = [](sqlite3_vfs* v, const char* name) {
+                auto p = parent_of(v);
+                return p->xGetSystemCall(p, name);
+            };
+            vfs.xNextSystemCall = [](sqlite3_vfs* v, const char* name) {
+                auto p = parent_of(v);
+                return p->xNextSystemCall(p, name);
+            };
+        }
+
+    }
+
+    vfs_shim(const vfs_shim&) = delete;
+    vfs_shim& operator=(const vfs_shim&) = delete;
+
+    virtual ~vfs_shim() {
+        uninstall();
+    }
+
+    void install(bool make_default = false) {
+        if(!installed) {
+            int ret = sqlite3_vfs_register(&vfs, make_default);
+            if(ret != SQLITE_OK) {
+                throw error(ret);
+            }
+            installed = true;
+        }
+    }
+
+    void uninstall() noexcept {
+        if(installed) {
+            sqlite3_vfs_unregister(&vfs);
+            installed = false;
+        }
+    }
+
+    const char* name() const noexcept {
+        return vfs_name.c_str();
+    }
+
+    sqlite3_vfs* parent() const noexcept {
+        return base_vfs;
+    }
+protected:
+    // Called for every file the wrapped VFS opened successfully. The returned object handles
+    // the file until SQLite closes it. name stays valid until then as well.
+    virtual std::unique_ptr<vfs_file> open_file(sqlite3_file* base, const char* name, int flags) {
+        return std::make_unique<vfs_file>(base, name, flags);
+    }
+private:
+    static sqlite3_vfs* parent_of(sqlite3_vfs* v) noexcept {
+        return static_cast<vfs_shim*>(v->pAppData)->base_vfs;
+    }
+
+    static int open_callback(sqlite3_vfs* v, const char* name, sqlite3_file* file, int flags, int* out_flags) noexcept {
+        auto self = static_cast<vfs_shim*>(v->pAppData);
+        auto handle = reinterpret_cast<detail::shim_handle*>(file);
+        auto base = reinterpret_cast<sqlite3_file*>(reinterpret_cast<char*>(file) + detail::shim_base_offset);
+        handle->header.pMethods = nullptr;
+        handle->file = nullptr;
+
+        int ret = self->base_vfs->xOpen(self->base_vfs, name, base, flags, out_flags);
+        if(base->pMethods == nullptr) {
+            return ret;
+        }
+
+        // SQLite still calls xClose on a failed open that left pMethods set, so the shim has to
+        // forward it; the file never reaches open_file though
+        if(ret != SQLITE_OK) {
+            handle->file = new(std::nothrow) vfs_file(base, name, flags);
+            if(handle->file == nullptr) {
+                base->pMethods->xClose(base);
+                return ret;
+            }
+            handle->header.pMethods = detail::shim_io_methods(base->pMethods->iVersion);
+            return ret;
+        }
+
+        ret = detail::guarded_io([&] {
+            handle->file = self->open_file(base, name, flags).release();
+            return SQLITE_OK;
+        });
+        if(ret != SQLITE_OK || handle->file == nullptr) {
+            base->pMethods->xClose(base);
+            return ret != SQLITE_OK ? ret : SQLITE_CANTOPEN;
+        }
+
+        handle->header.pMethods = detail::shim_io_methods(base->pMethods->iVersion);
+        return SQLITE_OK;
+    }
+
+    std::string vfs_name;
+    sqlite3_vfs* base_vfs = nullptr;
+    sqlite3_vfs vfs{};
+    bool installed = false;
+};
+
+struct io_counter {
+    uint64_t calls = 0;
+    uint64_t bytes = 0;
+    std::chrono::nanoseconds time{0};
+    std::chrono::nanoseconds max_time{0};
+};
+
+// I/O done on every file of the same name and type, summed over all the times it was opened
+struct file_io_stats {
+    std::string name; // empty for temporary files
+    int type = 0;     // see vfs_file::type
+    uint64_t opens = 0;
+    io_counter reads;
+    io_counter writes;
+    io_counter syncs;
+    io_counter truncates;
+    // reads served from the read-ahead buffer, these never reach the wrapped file
+    uint64_t readahead_hits = 0;
+    // writes gathered into a larger one instead of being issued on their own
+    uint64_t coalesced_writes = 0;
+};
+
+struct io_stats_options {
+    // Small sequential writes to the WAL and to temporary files are gathered into a buffer of
+    // this many bytes and issued together, 0 turns it off. The WAL buffer is written out at the
+    // end of each commit frame so other connections never miss a committed transaction.
+    // Rollback journals and the database file itself are always written straight through.
+    size_t coalesce_bytes = 0;
+
+    // A read of the main database file that continues where the previous one left off reads
+    // this many bytes instead and serves the following reads from them, 0 turns it off.
+    // The buffer is dropped whenever the file is written or a lock changes.
+    size_t readahead_bytes = 0;
+};
+
+namespace detail {
+struct atomic_io_counter {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> nanoseconds{0};
+    std::atomic<uint64_t> max_nanoseconds{0};
+
+    void record(uint64_t size, std::chrono::steady_clock::duration elapsed) noexcept {
+        auto ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        calls.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(size, std::memory_order_relaxed);
+        nanoseconds.fetch_add(ns, std::memory_order_relaxed);
+        auto current = max_nanoseconds.load(std::memory_order_relaxed);
+        while(ns > current && !max_nanoseconds.compare_exchange_weak(current, ns, std::memory_order_relaxed)) {}
+    }
+
+    io_counter load() const noexcept {
+        io_counter result;
+        result.calls = calls.load(std::memory_order_relaxed);
+        result.bytes = bytes.load(std::memory_order_relaxed);
+        result.time = std::chrono::nanoseconds(nanoseconds.load(std::memory_order_relaxed));
+        result.max_time = std::chrono::nanoseconds(max_nanoseconds.load(std::memory_order_relaxed));
+        return result;
+    }
+
+    void clear() noexcept {
+        calls.store(0, std::memory_order_relaxed);
+        bytes.store(0, std::memory_order_relaxed);
+        nanoseconds.store(0, std::memory_order_relaxed);
+        max_nanoseconds.store(0, std::memory_order_relaxed);
+    }
+};
+
+struct file_io_entry {
+    std::atomic<uint64_t> opens{0};
+    atomic_io_counter reads;
+    atomic_io_counter writes;
+    atomic_io_counter syncs;
+    atomic_io_counter truncates;
+    std::atomic<uint64_t> readahead_hits{0};
+    std::atomic<uint64_t> coalesced_writes{0};
+};
+
+struct io_stats_file : vfs_file {
+    using clock = std::chrono::steady_clock;
+
+    io_stats_file(sqlite3_file* base, const char* name, int flags, file_io_entry& stats, const io_stats_options& opts):
+        vfs_file(base, name, flags), stats(stats) {
+        int kind = type();
+        bool wal = kind == SQLITE_OPEN_WAL;
+        bool temporary = (kind & (SQLITE_OPEN_TEMP_DB | SQLITE_OPEN_TRANSIENT_DB | SQLITE_OPEN_TEMP_JOURNAL | SQLITE_OPEN_SUBJOURNAL)) != 0;
+        is_wal = wal;
+        if(opts.coalesce_bytes != 0 && (wal || temporary)) {
+            coalesce_limit = opts.coalesce_bytes;
+            pending.reserve(coalesce_limit);
+        }
+        if(opts.readahead_bytes != 0 && kind == SQLITE_OPEN_MAIN_DB) {
+            readahead_limit = opts.readahead_bytes;
+        }
+    }
+
+    int close() override {
+        int ret = flush();
+        int closed = vfs_file::close();
+        return ret != SQLITE_OK ? ret : closed;
+    }
+
+    int read(void* buffer, int amount, sqlite3_int64 offset) override {
+        int ret = flush();
+        if(ret != SQLITE_OK) {
+            return ret;
+        }
+
+        auto size = static_cast<size_t>(amount);
+        if(readahead_limit != 0) {
+            if(offset >= ahead_offset && offset + amount <= ahead_offset + static_cast<sqlite3_int64>(ahead_size)) {
+                std::memcpy(buffer, ahead.data() + (offset - ahead_offset), size);
+                stats.readahead_hits.fetch_add(1, std::memory_order_relaxed);
+                last_read_end = offset + amount;
+                return SQLITE_OK;
+            }
+
+            if(offset == last_read_end && size < readahead_limit && fill_readahead(offset, size)) {
+                std::memcpy(buffer, ahead.data(), size);
+                last_read_end = offset + amount;
+                return SQLITE_OK;
+            }
+            last_read_end = offset + amount;
+        }
+
+        auto start = clock::now();
+        ret = vfs_file::read(buffer, amount, offset);
+        stats.reads.record(size, clock::now() - start);
+        return ret;
+    }
+
+    int write(const void* buffer, int amount, sqlite3_int64 offset) override {
+        ahead_size = 0;
+        auto size = static_cast<size_t>(amount);
+        if(coalesce_limit != 0 && size < coalesce_limit) {
+            if(!pending.empty() && offset != pending_offset + static_cast<sqlite3_int64>(pending.size())) {
+                int ret = flush();
+                if(ret != SQLITE_OK) {
+                    return ret;
+                }
+            }
+
+            if(pending.empty()) {
+                pending_offset = offset;
+            }
+            auto bytes = static_cast<const char*>(buffer);
+            pending.insert(pending.end(), bytes, bytes + size);
+            stats.coalesced_writes.fetch_add(1, std::memory_order_relaxed);
+
+            // a WAL frame header is 24 bytes and has the database size after a commit in bytes 4 to 7,
+            // the page that follows it is the last write of the transaction
+            bool commit_header = is_wal && size == 24 && (bytes[4] | bytes[5] | bytes[6] | bytes[7]) != 0;
+            bool commit_done = commit_pending && !commit_header;
+            commit_pending = commit_header;
+            if(commit_done || pending.size() >= coalesce_limit) {
+                return flush();
+            }
+            return SQLITE_OK;
+        }
+
+        int ret = flush();
+        if(ret != SQLITE_OK) {
+            return ret;
+        }
+        commit_pending = false;
+        return write_through(buffer, size, offset);
+    }
+
+    int truncate(sqlite3_int64 size) override {
+        ahead_size = 0;
+        int ret = flush();
+        if(ret != SQLITE_OK) {
+            return ret;
+        }
+        auto start = clock::now();
+        ret = vfs_file::truncate(size);
+        stats.truncates.record(0, clock::now() - start);
+        return ret;
+    }
+
+    int sync(int flags) override {
+        int ret = flush();
+        if(ret != SQLITE_OK) {
+            return ret;
+        }
+        auto start = clock::now();
+        ret = vfs_file::sync(flags);
+        stats.syncs.record(0, clock::now() - start);
+        return ret;
+    }
+
+    int file_size(sqlite3_int64* size) override {
+        int ret = flush();
+        return ret != SQLITE_OK ? ret : vfs_file::file_size(size);
+    }
+
+    int lock(int level) override {
+        ahead_size = 0;
+        int ret = flush();
+        return ret != SQLITE_OK ? ret : vfs_file::lock(level);
+    }
+
+    int unlock(int level) override {
+        ahead_size = 0;
+        int ret = flush();
+        return ret != SQLITE_OK ? ret : vfs_file::unlock(level);
+    }
+
+    int file_control(int op, void* arg) override {
+        int ret = flush();
+        return ret != SQLITE_OK ? ret : vfs_file::file_control(op, arg);
+    }
+
+    // other connections change the database between read transactions, which always take a shm lock
+    int shm_lock(int offset, int n, int flags) override {
+        ahead_size = 0;
+        return vfs_file::shm_lock(offset, n, flags);
+    }
+
+    void shm_barrier() override {
+        ahead_size = 0;
+        vfs_file::shm_barrier();
+    }
+
+    int fetch(sqlite3_int64 offset, int amount, void** out) override {
+        int ret = flush();
+        return ret != SQLITE_OK ? ret : vfs_file::fetch(offset, amount, out);
+    }
+private:
+    int write_through(const void* buffer, size_t size, sqlite3_int64 offset) {
+        auto start = clock::now();
+        int ret = vfs_file::write(buffer, static_cast<int>(size), offset);
+        stats.writes.record(size, clock::now() - start);
+        return ret;
+    }
+
+    int flush() {
+        if(pending.empty()) {
+            return SQLITE_OK;
+        }
+        int ret = write_through(pending.data(), pending.size(), pending_offset);
+        pending.clear();
+        return ret;
+    }
+
+    bool fill_readahead(sqlite3_int64 offset, size_t size) {
+        sqlite3_int64 end = 0;
+        if(vfs_file::file_size(&end) != SQLITE_OK || end - offset < static_cast<sqlite3_int64>(size)) {
+            return false;
+        }
+
+        auto length = static_cast<size_t>(std::min<sqlite3_int64>(static_cast<sqlite3_int64>(readahead_limit), end - offset));
+        ahead.resize(readahead_limit);
+        auto start = clock::now();
+        int ret = vfs_file::read(ahead.data(), static_cast<int>(length), offset);
+        stats.reads.record(length, clock::now() - start);
+        if(ret != SQLITE_OK) {
+            ahead_size = 0;
+            return false;
+        }
+        ahead_offset = offset;
+        ahead_size = length;
+        return true;
+    }
+
+    file_io_entry& stats;
+    bool is_wal = false;
+    bool commit_pending = false;
+
+    size_t coalesce_limit = 0;
+    std::vector<char> pending;
+    sqlite3_int64 pending_offset = 0;
+
+    size_t readahead_limit = 0;
+    std::vector<char> ahead;
+    sqlite3_int64 ahead_offset = 0;
+    size_t ahead_size = 0;
+    sqlite3_int64 last_read_end = -1;
+};
+} // detail
+
+// A shim that counts the reads, writes, syncs and truncates of every file along with their
+// sizes and latencies, and optionally coalesces writes or reads ahead, see io_stats_options.
+// e.g.
+//
+// sqlite::io_stats_vfs stats("io_stats");
+// sqlite::connection con("data.db", sqlite::connection::read_write, stats.name());
+// ...
+// for(auto&& file : stats.snapshot()) { ... }
+struct io_stats_vfs : vfs_shim {
+    explicit io_stats_vfs(std::string name = "sqlitexx_io_stats", io_stats_options opts = {}, const char* parent = nullptr):
+        vfs_shim(std::move(name), parent), opts(opts) {
+        install();
+    }
+
+    ~io_stats_vfs() override {
+        uninstall();
+    }
+
+    std::vector<file_io_stats> snapshot() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<file_io_stats> result;
+        result.reserve(files.size());
+        for(auto&& entry : files) {
+            file_io_stats item;
+            item.name = entry.first.first;
+            item.type = entry.first.second;
+            item.opens = entry.second.opens.load(std::memory_order_relaxed);
+            item.reads = entry.second.reads.load();
+            item.writes = entry.second.writes.load();
+            item.syncs = entry.second.syncs.load();
+            item.truncates = entry.second.truncates.load();
+            item.readahead_hits = entry.second.readahead_hits.load(std::memory_order_relaxed);
+            item.coalesced_writes = entry.second.coalesced_writes.load(std::memory_order_relaxed);
+            result.push_back(std::move(item));
+        }
+        return result;
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for(auto&& entry : files) {
+            auto&& stats = entry.second;
+            stats.opens.store(0, std::memory_order_relaxed);
+            stats.reads.clear();
+            stats.writes.clear();
+            stats.syncs.clear();
+            stats.truncates.clear();
+            stats.readahead_hits.store(0, std::memory_order_relaxed);
+            stats.coalesced_writes.store(0, std::memory_order_relaxed);
+        }
+    }
+protected:
+    std::unique_ptr<vfs_file> open_file(sqlite3_file* base, const char* name, int flags) override {
+        return std::make_unique<detail::io_stats_file>(base, name, flags, entry(name, flags), opts);
+    }
+private:
+    detail::file_io_entry& entry(const char* name, int flags) {
+        std::lock_guard<std::mutex> lock(mutex);
+        // entries are never erased so the reference stays valid for as long as the file is open
+        auto&& stats = files[{ name == nullptr ? std::string() : std::string(name), detail::file_type(flags) }];
+        stats.opens.fetch_add(1, std::memory_order_relaxed);
+        return stats;
+    }
+
+    io_stats_options opts;
+    mutable std::mutex mutex;
+    std::map<std::pair<std::string, int>, detail::file_io_entry> files;
+};
+} // sqlite
@@ -0,0 +1,537 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <sqlitexx/type_traits.hpp>
+#include <sqlitexx/error.hpp>
+#include <sqlitexx/mapping.hpp>
+#include <sqlitexx/function.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+#include <sqlite3.h>
+
+namespace sqlite {
+namespace detail {
+template<typename T, typename = void>
+struct vtab_field {
+    static constexpr const char* declared_type = "";
+    static constexpr bool orderable = false;
+
+    static int compare(const T&, sqlite3_value*, bool&) noexcept {
+        return 0;
+    }
+};
+
+// Compares a field against a constraint value the way SQLite would. Values of a different
+// storage class can't be compared in C++ so comparable is cleared and the bound is ignored.
+template<typename T>
+struct vtab_field<T, std::enable_if_t<std::is_arithmetic<T>::value>> {
+    static constexpr const char* declared_type = std::is_floating_point<T>::value ? "REAL" : "INTEGER";
+    static constexpr bool orderable = true;
+
+    template<typename U>
+    static int three_way(U lhs, U rhs) noexcept {
+        return lhs < rhs ? -1 : rhs < lhs ? 1 : 0;
+    }
+
+    // numeric affinity is applied first, the same as comparing against an INTEGER or REAL column
+    static int compare(const T& field, sqlite3_value* value, bool& comparable) noexcept {
+        switch(sqlite3_value_numeric_type(value)) {
+        case SQLITE_INTEGER:
+            if(std::is_integral<T>::value) {
+                return three_way<sqlite3_int64>(field, sqlite3_value_int64(value));
+            }
+            return three_way<double>(field, static_cast<double>(sqlite3_value_int64(value)));
+        case SQLITE_FLOAT:
+            return three_way<double>(field, sqlite3_value_double(value));
+        default:
+            comparable = false;
+            return 0;
+        }
+    }
+};
+
+template<typename... Rest>
+struct vtab_field<std::basic_string<char, Rest...>> {
+    static constexpr const char* declared_type = "TEXT";
+    static constexpr bool orderable = true;
+
+    // the BINARY collation
+    static int compare(const std::basic_string<char, Rest...>& field, sqlite3_value* value, bool& comparable) noexcept {
+        if(sqlite3_value_type(value) != SQLITE_TEXT) {
+            comparable = false;
+            return 0;
+        }
+
+        auto str = sqlite3_value_text(value);
+        size_t size = static_cast<size_t>(sqlite3_value_bytes(value));
+        int ret = std::memcmp(field.data(), str, std::min(field.size(), size));
+        return ret != 0 ? ret : field.size() < size ? -1 : field.size() > size ? 1 : 0;
+    }
+};
+
+// the per column operations of a mapped struct, indexed by column number
+template<typename T>
+struct vtab_columns {
+    static constexpr size_t size = meta::field_count<T>::value;
+
+    using result_function = void(*)(sqlite3_context*, const T&);
+    using compare_function = int(*)(const T&, sqlite3_value*, bool&);
+
+    template<size_t I>
+    static void result(sqlite3_context* ctx, const T& row) {
+        constexpr auto fields = row_mapping<T>::fields();
+        meta::result_traits<meta::field_value_t<T, I>>::set(ctx, row.*(std::get<I>(fields).member));
+    }
+
+    template<size_t I>
+    static int compare(const T& row, sqlite3_value* value, bool& comparable) noexcept {
+        constexpr auto fields = row_mapping<T>::fields();
+        return vtab_field<meta::field_value_t<T, I>>::compare(row.*(std::get<I>(fields).member), value, comparable);
+    }
+
+    template<size_t... I>
+    static std::string schema(std::index_sequence<I...>) {
+        constexpr auto fields = row_mapping<T>::fields();
+        std::string sql = "CREATE TABLE x(";
+        const char* separator = "";
+        using dummy = int[];
+        (void)dummy{ 0, (sql.append(separator).append(1, '"').append(std::get<I>(fields).name)
+                            .append("\" ").append(vtab_field<meta::field_value_t<T, I>>::declared_type),
+                         separator = ", ", 0)... };
+        return sql.append(")");
+    }
+
+    template<size_t... I>
+    static const result_function* results(std::index_sequence<I...>) noexcept {
+        static const result_function table[] = { &result<I>... };
+        return table;
+    }
+
+    template<size_t... I>
+    static const compare_function* comparisons(std::index_sequence<I...>) noexcept {
+        static const compare_function table[] = { &compare<I>... };
+        return table;
+    }
+
+    template<size_t... I>
+    static const bool* orderable(std::index_sequence<I...>) noexcept {
+        static const bool table[] = { vtab_field<meta::field_value_t<T, I>>::orderable... };
+        return table;
+    }
+};
+
+// xBestIndex plans are packed into idxNum, the key slot + 1 above the bound flags
+enum vtab_plan : int {
+    plan_eq          = 1,
+    plan_lower       = 2,
+    plan_lower_equal = 4,
+    plan_upper       = 8,
+    plan_upper_equal = 16,
+    plan_flag_bits   = 5
+};
+
+template<typename Range>
+struct range_module {
+    using row_type = meta::unqualified_t<decltype(*std::begin(std::declval<const Range&>()))>;
+    using columns = vtab_columns<row_type>;
+
+    struct key_index {
+        int column;
+        // row positions sorted by the column
+        std::vector<size_t> order;
+    };
+
+    struct table : sqlite3_vtab {
+        range_module* owner;
+    };
+
+    struct cursor : sqlite3_vtab_cursor {
+        const size_t* order; // nullptr when rows are visited in container order
+        size_t position;
+        size_t end;
+    };
+
+    range_module(const Range& range, const std::vector<std::string>& keys): range(range) {
+        constexpr auto sequence = std::make_index_sequence<columns::size>{};
+        sql = columns::schema(sequence);
+        results = columns::results(sequence);
+        comparisons = columns::comparisons(sequence);
+
+        auto names = ::sqlite::column_names<row_type>();
+        auto orderable = columns::orderable(sequence);
+        for(auto&& key : keys) {
+            auto it = std::find(names.begin(), names.end(), key);
+            if(it == names.end() || !orderable[it - names.begin()]) {
+                throw error(SQLITE_RANGE);
+            }
+
+            key_index index;
+            index.column = static_cast<int>(it - names.begin());
+            build(index);
+            indexes.push_back(std::move(index));
+        }
+
+        module.iVersion = 1;
+        // no xCreate makes this an eponymous-only table, usable without CREATE VIRTUAL TABLE
+        module.xConnect = &connect;
+        module.xBestIndex = &best_index;
+        module.xDisconnect = &disconnect;
+        module.xDestroy = &disconnect;
+        module.xOpen = &open;
+        module.xClose = &close;
+        module.xFilter = &filter;
+        module.xNext = &next;
+        module.xEof = &eof;
+        module.xColumn = &column;
+        module.xRowid = &rowid;
+    }
+
+    size_t size() const noexcept {
+        return static_cast<size_t>(std::distance(std::begin(range), std::end(range)));
+    }
+
+    const row_type& row(size_t index) const noexcept {
+        return std::begin(range)[index];
+    }
+
+    void build(key_index& key) {
+        key.order.resize(size());
+        std::iota(key.order.begin(), key.order.end(), size_t(0));
+        auto less = [this, &key](size_t lhs, size_t rhs) {
+            return compare_rows(key.column, row(lhs), row(rhs));
+        };
+        std::stable_sort(key.order.begin(), key.order.end(), less);
+    }
+
+    static bool compare_rows(int column, const row_type& lhs, const row_type& rhs) noexcept {
+        return less_than(column, lhs, rhs, std::make_index_sequence<columns::size>{});
+    }
+
+    template<size_t... I>
+    static bool less_than(int column, const row_type& lhs, const row_type& rhs, std::index_sequence<I...>) noexcept {
+        constexpr auto fields = row_mapping<row_type>::fields();
+        bool result = false;
+        using dummy = int[];
+        (void)dummy{ 0, (column == static_cast<int>(I) ? (result = field_less(lhs.*(std::get<I>(fields).member),
+                                                                              rhs.*(std::get<I>(fields).member)), 0) : 0)... };
+        return result;
+    }
+
+    template<typename U>
+    static bool field_less(const U& lhs, const U& rhs) noexcept {
+        return field_less(lhs, rhs, std::integral_constant<bool, vtab_field<U>::orderable>{});
+    }
+
+    template<typename U>
+    static bool field_less(const U& lhs, const U& rhs, std::true_type) noexcept {
+        return lhs < rhs;
+    }
+
+    template<typename U>
+    static bool field_less(const U&, const U&, std::false_type) noexcept {
+        return false;
+    }
+
+    static int connect(sqlite3* db, void* aux, int, const char* const*, sqlite3_vtab** out, char**) noexcept {
+        auto self = static_cast<range_module*>(aux);
+        int ret = sqlite3_declare_vtab(db, self->sql.c_str());
+        if(ret != SQLITE_OK) {
+            return ret;
+        }
+
+        auto vtab = static_cast<table*>(sqlite3_malloc(sizeof(table)));
+        if(vtab == nullptr) {
+            return SQLITE_NOMEM;
+        }
+
+        std::memset(vtab, 0, sizeof(table));
+        vtab->owner = self;
+        *out = vtab;
+        return SQLITE_OK;
+    }
+
+    static int disconnect(sqlite3_vtab* vtab) noexcept {
+        sqlite3_free(vtab);
+        return SQLITE_OK;
+    }
+
+    template<size_t... I>
+    static const char* const* declared_types(std::index_sequence<I...>) noexcept {
+        static const char* const table[] = { vtab_field<meta::field_value_t<row_type, I>>::declared_type... };
+        return table;
+    }
+
+    // only text is collation sensitive and it's compared with BINARY
+    static bool usable_collation(sqlite3_index_info* info, int constraint, int column) noexcept {
+        auto type = declared_types(std::make_index_sequence<columns::size>{})[column];
+        if(std::strcmp(type, "TEXT") != 0) {
+            return true;
+        }
+#if SQLITE_VERSION_NUMBER >= 3022000
+        auto name = sqlite3_vtab_collation(info, constraint);
+        return name == nullptr || sqlite3_stricmp(name, "BINARY") == 0;
+#else
+        (void)info;
+        (void)constraint;
+        return false;
+#endif
+    }
+
+    static int best_index(sqlite3_vtab* vtab, sqlite3_index_info* info) noexcept {
+        auto&& self = *static_cast<table*>(vtab)->owner;
+        double rows = static_cast<double>(self.size());
+        double log_rows = std::log2(rows + 1.0) + 1.0;
+
+        // pick the key with the most selective set of constraints
+        int best_slot = -1;
+        int best_flags = 0;
+        int best_eq = -1, best_lower = -1, best_upper = -1;
+        double best_cost = rows;
+
+        for(size_t slot = 0; slot < self.indexes.size(); ++slot) {
+            int column = self.indexes[slot].column;
+            int flags = 0;
+            int eq = -1, lower = -1, upper = -1;
+            for(int i = 0; i < info->nConstraint; ++i) {
+                auto&& c = info->aConstraint[i];
+                if(!c.usable || c.iColumn != column || !usable_collation(info, i, column)) {
+                    continue;
+                }
+
+                switch(c.op) {
+                case SQLITE_INDEX_CONSTRAINT_EQ:
+                    if(eq < 0) {
+                        eq = i;
+                        flags |= plan_eq;
+                    }
+                    break;
+                case SQLITE_INDEX_CONSTRAINT_GT:
+                case SQLITE_INDEX_CONSTRAINT_GE:
+                    if(lower < 0) {
+                        lower = i;
+                        flags |= plan_lower | (c.op == SQLITE_INDEX_CONSTRAINT_GE ? plan_lower_equal : 0);
+                    }
+                    break;
+                case SQLITE_INDEX_CONSTRAINT_LT:
+                case SQLITE_INDEX_CONSTRAINT_LE:
+                    if(upper < 0) {
+                        upper = i;
+                        flags |= plan_upper | (c.op == SQLITE_INDEX_CONSTRAINT_LE ? plan_upper_equal : 0);
+                    }
+                    break;
+                }
+            }
+
+            double cost = rows;
+            if(flags & plan_eq) {
+                flags = plan_eq;
+                cost = log_rows;
+            }
+            else if((flags & plan_lower) && (flags & plan_upper)) {
+                cost = rows / 4.0 + log_rows;
+            }
+            else if(flags != 0) {
+                cost = rows / 2.0 + log_rows;
+            }
+
+            if(cost < best_cost) {
+                best_slot = static_cast<int>(slot);
+                best_flags = flags;
+                best_eq = eq;
+                best_lower = lower;
+                best_upper = upper;
+                best_cost = cost;
+            }
+        }
+
+        // a single ascending ORDER BY on a key can be answered by walking its index
+        bool ordered = false;
+        if(info->nOrderBy == 1 && !info->aOrderBy[0].desc) {
+            int column = info->aOrderBy[0].iColumn;
+            if(best_slot >= 0) {
+                ordered = self.indexes[best_slot].column == column;
+            }
+            else {
+                for(size_t slot = 0; slot < self.indexes.size(); ++slot) {
+                    if(self.indexes[slot].column == column) {
+                        best_slot = static_cast<int>(slot);
+                        ordered = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        // SQLite still checks every constraint itself since values of another type aren't narrowed
+        int argument = 0;
+        if(best_flags & plan_eq) {
+            info->aConstraintUsage[best_eq].argvIndex = ++argument;
+        }
+        else {
+            if(best_flags & plan_lower) {
+                info->aConstraintUsage[best_lower].argvIndex = ++argument;
+            }
+            if(best_flags & plan_upper) {
+                info->aConstraintUsage[best_upper].argvIndex = ++argument;
+            }
+        }
+
+        info->idxNum = ((best_slot + 1) << plan_flag_bits) | best_flags;
+        info->orderByConsumed = ordered;
+        info->estimatedCost = best_cost;
+        info->estimatedRows = static_cast<sqlite3_int64>(best_flags & plan_eq ? 1.0 : best_cost);
+        return SQLITE_OK;
+    }
+
+    static int open(sqlite3_vtab*, sqlite3_vtab_cursor** out) noexcept {
+        auto cur = static_cast<cursor*>(sqlite3_malloc(sizeof(cursor)));
+        if(cur == nullptr) {
+            return SQLITE_NOMEM;
+        }
+
+        std::memset(cur, 0, sizeof(cursor));
+        *out = cur;
+        return SQLITE_OK;
+    }
+
+    static int close(sqlite3_vtab_cursor* cur) noexcept {
+        sqlite3_free(cur);
+        return SQLITE_OK;
+    }
+
+    // the first position in the key's order where the row compares greater than (or equal to) value
+    const size_t* bound(const key_index& key, const size_t* first, const size_t* last, sqlite3_value* value, bool inclusive) const noexcept {
+        auto compare = comparisons[key.column];
+        bool comparable = true;
+        auto it = std::partition_point(first, last, [&](size_t index) {
+            int ret = compare(row(index), value, comparable);
+            return inclusive ? ret < 0 : ret <= 0;
+        });
+        return comparable ? it : nullptr;
+    }
+
+    static int filter(sqlite3_vtab_cursor* ptr, int plan, const char*, int, sqlite3_value** argv) noexcept {
+        auto cur = static_cast<cursor*>(ptr);
+        auto&& self = *static_cast<table*>(ptr->pVtab)->owner;
+        int slot = (plan >> plan_flag_bits) - 1;
+        int flags = plan & ((1 << plan_flag_bits) - 1);
+
+        cur->position = 0;
+        cur->end = self.size();
+        cur->order = nullptr;
+        if(slot < 0) {
+            return SQLITE_OK;
+        }
+
+        auto&& key = self.indexes[slot];
+        const size_t* first = key.order.data();
+        const size_t* last = first + key.order.size();
+        const size_t* begin = first;
+        const size_t* end = last;
+        if(flags & plan_eq) {
+            auto lo = self.bound(key, first, last, argv[0], true);
+            auto hi = self.bound(key, first, last, argv[0], false);
+            if(lo && hi) {
+                begin = lo;
+                end = hi;
+            }
+        }
+        else {
+            int argument = 0;
+            if(flags & plan_lower) {
+                auto lo = self.bound(key, first, last, argv[argument++], (flags & plan_lower_equal) != 0);
+                begin = lo ? lo : begin;
+            }
+            if(flags & plan_upper) {
+                auto hi = self.bound(key, first, last, argv[argument++], (flags & plan_upper_equal) == 0);
+                end = hi ? hi : end;
+            }
+            end = std::max(begin, end);
+        }
+
+        cur->order = first;
+        cur->position = static_cast<size_t>(begin - first);
+        cur->end = static_cast<size_t>(end - first);
+        return SQLITE_OK;
+    }
+
+    static int next(sqlite3_vtab_cursor* ptr) noexcept {
+        ++static_cast<cursor*>(ptr)->position;
+        return SQLITE_OK;
+    }
+
+    static int eof(sqlite3_vtab_cursor* ptr) noexcept {
+        auto cur = static_cast<cursor*>(ptr);
+        return cur->position >= cur->end;
+    }
+
+    static size_t current(sqlite3_vtab_cursor* ptr) noexcept {
+        auto cur = static_cast<cursor*>(ptr);
+        return cur->order ? cur->order[cur->position] : cur->position;
+    }
+
+    static int column(sqlite3_vtab_cursor* ptr, sqlite3_context* ctx, int index) noexcept {
+        auto&& self = *static_cast<table*>(ptr->pVtab)->owner;
+        set_result(ctx, [&] { self.results[index](ctx, self.row(current(ptr))); });
+        return SQLITE_OK;
+    }
+
+    static int rowid(sqlite3_vtab_cursor* ptr, sqlite3_int64* out) noexcept {
+        *out = static_cast<sqlite3_int64>(current(ptr));
+        return SQLITE_OK;
+    }
+
+    static void destroy(void* ptr) noexcept {
+        delete static_cast<range_module*>(ptr);
+    }
+
+    const Range& range;
+    std::string sql;
+    const typename columns::result_function* results;
+    const typename columns::compare_function* comparisons;
+    std::vector<key_index> indexes;
+    sqlite3_module module{};
+};
+
+template<typename Range>
+inline void create_range_table(sqlite3* db, const char* name, const Range& range, const std::vector<std::string>& keys) {
+    using module = range_module<Range>;
+    std::unique_ptr<module> ptr(new module(range, keys));
+    auto table = &ptr->module;
+    // SQLite calls the destructor itself if registering fails
+    int ret = sqlite3_create_module_v2(db, name, table, ptr.release(), &module::destroy);
+    if(ret != SQLITE_OK) {
+        throw error(ret);
+    }
+}
+} // detail
+} // sqlite
@@ -164,6 +164,12 @@ def main():
     generator = SingleFileGenerator(args, 'sqlitexx', 'https://github.com/Rapptz/sqlitexx')
     generator.change_directory('include')
     generator.process_file('sqlitexx/connection.hpp')
+    generator.process_file('sqlitexx/bulk.hpp')
+    generator.process_file('sqlitexx/pool.hpp')
+    generator.process_file('sqlitexx/async.hpp')
+    generator.process_file('sqlitexx/blob_stream.hpp')
+    generator.process_file('sqlitexx/backup.hpp')
+    generator.process_file('sqlitexx/parallel.hpp')
     generator.write_to_file()
 
 if __name__ == '__main__':
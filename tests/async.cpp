@@ -0,0 +1,145 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// write_executor: jobs queued together share a transaction, a failing job only rolls back
+// itself, and a connection that can't be set up fails every job.
+
+#include "test.hpp"
+
+#include <sqlitexx/async.hpp>
+
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+const char filename[] = "sqlitexx_test_async.db";
+
+sqlite::write_options options() {
+    sqlite::write_options opts;
+    opts.max_batch = 64;
+    opts.max_latency = std::chrono::milliseconds(20);
+    opts.setup = [](sqlite::connection& con) {
+        con.execute("PRAGMA journal_mode = WAL; CREATE TABLE IF NOT EXISTS t(a INTEGER);");
+    };
+    return opts;
+}
+
+// the counters are updated right after a batch's futures are made ready, so wait for them to catch up
+sqlite::write_stats settled(const sqlite::write_executor& executor, size_t jobs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    auto stats = executor.stats();
+    while(stats.jobs < jobs && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+        stats = executor.stats();
+    }
+    return stats;
+}
+
+TEST_CASE(group_commit) {
+    test::remove_database(filename);
+    std::vector<std::future<long long>> results;
+    sqlite::write_stats stats;
+    {
+        sqlite::write_executor executor(filename, options());
+        for(int i = 0; i < 200; ++i) {
+            results.push_back(executor.submit([i](sqlite::connection& con) {
+                con.prepare_cached("INSERT INTO t VALUES (?);").execute(i);
+                return static_cast<long long>(sqlite3_last_insert_rowid(con.data()));
+            }));
+        }
+        results.back().wait();
+        stats = settled(executor, 200);
+    }
+
+    bool inserted = true;
+    for(auto&& result : results) {
+        inserted = inserted && result.get() > 0;
+    }
+    CHECK(inserted);
+    CHECK(stats.jobs == 200);
+    CHECK(stats.failed_jobs == 0);
+    CHECK(stats.batches < stats.jobs);
+    CHECK(stats.largest_batch > 1);
+    CHECK(stats.largest_batch <= 64);
+
+    sqlite::connection con(filename, sqlite::connection::read_write);
+    CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 200);
+}
+
+TEST_CASE(failing_job_rolls_back_alone) {
+    test::remove_database(filename);
+    std::future<void> before, failing, after;
+    std::future<int> sql_error;
+    {
+        sqlite::write_executor executor(filename, options());
+        before = executor.submit([](sqlite::connection& con) { con.execute("INSERT INTO t VALUES (1);"); });
+        failing = executor.submit([](sqlite::connection& con) {
+            con.execute("INSERT INTO t VALUES (-1);");
+            throw std::runtime_error("job failed");
+        });
+        sql_error = executor.submit([](sqlite::connection& con) {
+            con.execute("INSERT INTO t VALUES (-2);");
+            con.execute("INSERT INTO missing VALUES (1);");
+            return 0;
+        });
+        after = executor.submit([](sqlite::connection& con) { con.execute("INSERT INTO t VALUES (2);"); });
+        after.wait();
+        CHECK(settled(executor, 4).failed_jobs == 2);
+    }
+
+    before.get();
+    after.get();
+    bool rethrown = false;
+    try {
+        failing.get();
+    }
+    catch(const std::runtime_error& e) {
+        rethrown = std::string(e.what()) == "job failed";
+    }
+    CHECK(rethrown);
+    CHECK_ERROR(SQLITE_ERROR, sql_error.get());
+
+    sqlite::connection con(filename, sqlite::connection::read_write);
+    CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 2);
+    CHECK(test::scalar(con, "SELECT count(*) FROM t WHERE a < 0;") == 0);
+}
+
+TEST_CASE(setup_failure_fails_every_job) {
+    sqlite::write_options opts;
+    opts.setup = [](sqlite::connection& con) { con.execute("THIS IS NOT SQL;"); };
+    sqlite::write_executor executor(test::memory(), opts);
+    auto first = executor.submit([](sqlite::connection&) { return 1; });
+    first.wait();
+    auto second = executor.submit([](sqlite::connection&) {});
+    CHECK_ERROR(SQLITE_ERROR, first.get());
+    CHECK_ERROR(SQLITE_ERROR, second.get());
+    CHECK(settled(executor, 2).failed_jobs == 2);
+}
+} // namespace
+
+int main() {
+    return test::run();
+}
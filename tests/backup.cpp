@@ -0,0 +1,113 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// backup: copying between connections in steps, stopping early, and giving up on a source
+// that stays locked.
+
+#include "test.hpp"
+
+#include <sqlitexx/backup.hpp>
+
+#include <chrono>
+
+namespace {
+const char source_file[] = "sqlitexx_test_backup_source.db";
+const char destination_file[] = "sqlitexx_test_backup_destination.db";
+
+// a few hundred pages worth of rows
+void fill(const sqlite::connection& con) {
+    con.execute("CREATE TABLE t(id INTEGER PRIMARY KEY, name TEXT);"
+                "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c WHERE x < 5000) "
+                "INSERT INTO t(name) SELECT printf('%.100c', x) FROM c;");
+}
+
+TEST_CASE(copy_in_steps) {
+    auto source = test::memory();
+    fill(source);
+    auto destination = test::fresh(destination_file);
+
+    int calls = 0;
+    sqlite::backup_options opts;
+    opts.pages_per_step = 16;
+    opts.progress = [&](int remaining, int total) {
+        CHECK(remaining >= 0 && remaining <= total);
+        ++calls;
+        return true;
+    };
+
+    sqlite::backup copy(destination, source);
+    CHECK(copy.run(opts));
+    CHECK(calls > 1);
+    CHECK(copy.remaining() == 0);
+    CHECK(copy.progress() == 1.0);
+    copy.finish();
+    CHECK(test::scalar(destination, "SELECT count(*) FROM t;") == 5000);
+}
+
+TEST_CASE(stopped_by_progress) {
+    auto source = test::memory();
+    fill(source);
+    auto destination = test::memory();
+
+    sqlite::backup_options opts;
+    opts.pages_per_step = 4;
+    opts.progress = [](int, int) { return false; };
+    sqlite::backup copy(destination, source);
+    CHECK(!copy.run(opts));
+    CHECK(copy.remaining() > 0);
+
+    // stepping the rest by hand finishes it
+    while(!copy.step(-1)) {}
+    copy.finish();
+    CHECK(test::scalar(destination, "SELECT count(*) FROM t;") == 5000);
+}
+
+TEST_CASE(busy_source_times_out) {
+    {
+        auto source = test::fresh(source_file);
+        fill(source);
+    }
+    sqlite::connection source(source_file, sqlite::connection::read_write);
+    auto destination = test::memory();
+    sqlite::connection locker(source_file, sqlite::connection::read_write);
+    locker.execute("BEGIN EXCLUSIVE; INSERT INTO t(name) VALUES ('locked');");
+
+    sqlite::backup_options opts;
+    opts.max_busy_wait = std::chrono::milliseconds(50);
+    opts.busy_pause = std::chrono::milliseconds(5);
+    sqlite::backup copy(destination, source);
+    auto start = std::chrono::steady_clock::now();
+    CHECK_ERROR(SQLITE_BUSY, copy.run(opts));
+    CHECK(std::chrono::steady_clock::now() - start >= opts.max_busy_wait);
+
+    // the same backup goes through once the lock is gone
+    locker.execute("ROLLBACK;");
+    CHECK(copy.run(opts));
+    copy.finish();
+    CHECK(test::scalar(destination, "SELECT count(*) FROM t;") == 5000);
+}
+} // namespace
+
+int main() {
+    return test::run();
+}
@@ -0,0 +1,105 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// blob_stream: chunked reads and writes, seeking, moving between rows, and the range checks.
+
+#include "test.hpp"
+
+#include <sqlitexx/blob_stream.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+sqlite::connection blobs() {
+    auto con = test::memory();
+    con.execute("CREATE TABLE t(id INTEGER PRIMARY KEY, data BLOB);"
+                "INSERT INTO t VALUES (1, zeroblob(1000)), (2, x'0102030405');");
+    return con;
+}
+
+TEST_CASE(write_then_read_in_chunks) {
+    auto con = blobs();
+    {
+        sqlite::blob_stream out(con, "t", "data", 1, sqlite::blob_stream::read_write);
+        CHECK(out.size() == 1000);
+        unsigned char chunk[64];
+        for(size_t offset = 0; offset < out.size(); offset += sizeof(chunk)) {
+            size_t count = std::min(sizeof(chunk), out.size() - offset);
+            for(size_t i = 0; i < count; ++i) {
+                chunk[i] = static_cast<unsigned char>((offset + i) % 251);
+            }
+            out.write(chunk, count);
+        }
+        CHECK(out.tell() == 1000);
+    }
+
+    sqlite::blob_stream in(con, "t", "data", 1);
+    std::vector<unsigned char> all;
+    unsigned char chunk[100];
+    size_t read;
+    while((read = in.read(chunk, sizeof(chunk) - 3)) != 0) {
+        all.insert(all.end(), chunk, chunk + read);
+    }
+    CHECK(all.size() == 1000);
+    bool same = true;
+    for(size_t i = 0; i < all.size(); ++i) {
+        same = same && all[i] == i % 251;
+    }
+    CHECK(same);
+}
+
+TEST_CASE(seek_and_reopen) {
+    auto con = blobs();
+    sqlite::blob_stream stream(con, "t", "data", 2);
+    stream.seek(3);
+    unsigned char byte = 0;
+    CHECK(stream.read(&byte, 1) == 1);
+    CHECK(byte == 4);
+
+    stream.reopen(1);
+    CHECK(stream.size() == 1000);
+    CHECK(stream.tell() == 0);
+    stream.close();
+    CHECK(!stream.is_open());
+}
+
+TEST_CASE(range_checks) {
+    auto con = blobs();
+    sqlite::blob_stream stream(con, "t", "data", 2, sqlite::blob_stream::read_write);
+    CHECK_ERROR(SQLITE_RANGE, stream.seek(6));
+    stream.seek(5);
+    unsigned char bytes[2] = { 0, 0 };
+    CHECK(stream.read(bytes, 2) == 0);
+    stream.seek(4);
+    CHECK_ERROR(SQLITE_RANGE, stream.write(bytes, 2));
+
+    sqlite::blob_stream reader(con, "t", "data", 2);
+    CHECK_ERROR(SQLITE_READONLY, reader.write(bytes, 1));
+    CHECK_ERROR(SQLITE_ERROR, sqlite::blob_stream(con, "t", "data", 3));
+}
+} // namespace
+
+int main() {
+    return test::run();
+}
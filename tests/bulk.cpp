@@ -0,0 +1,135 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// bulk_writer: how rows are split into statements and transactions, quoting, and reuse after
+// a failed write.
+
+#include "test.hpp"
+
+#include <sqlitexx/bulk.hpp>
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+std::vector<std::tuple<int, std::string>> make_rows(int count) {
+    std::vector<std::tuple<int, std::string>> rows;
+    for(int i = 0; i < count; ++i) {
+        rows.emplace_back(i, "row " + std::to_string(i));
+    }
+    return rows;
+}
+
+int count_commit(void* context) {
+    ++*static_cast<int*>(context);
+    return 0;
+}
+
+TEST_CASE(transactions_per_chunk) {
+    auto con = test::memory();
+    con.execute("CREATE TABLE t(id INTEGER PRIMARY KEY, name TEXT);");
+    int commits = 0;
+    sqlite3_commit_hook(con.data(), count_commit, &commits);
+
+    sqlite::bulk_options opts;
+    opts.rows_per_transaction = 100;
+    sqlite::bulk_writer writer(con, "t", { "id", "name" }, opts);
+    CHECK(writer.write(make_rows(1050)) == 1050);
+    CHECK(commits == 11);
+    CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 1050);
+    CHECK(test::scalar(con, "SELECT sum(id) FROM t;") == 1050 * 1049 / 2);
+}
+
+TEST_CASE(multi_row_statements) {
+    auto con = test::memory();
+    con.execute("CREATE TABLE t(id INTEGER PRIMARY KEY, name TEXT);");
+    int commits = 0;
+    sqlite3_commit_hook(con.data(), count_commit, &commits);
+
+    sqlite::bulk_options opts;
+    opts.multi_row = true;
+    opts.max_rows_per_statement = 64;
+    opts.rows_per_transaction = 512;
+    sqlite::bulk_writer writer(con, "t", { "id", "name" }, opts);
+    CHECK(writer.statement_rows() == 64);
+
+    // 1000 rows are two transactions, the second ends with a remainder written row by row
+    CHECK(writer.write(make_rows(1000)) == 1000);
+    CHECK(commits == 2);
+    CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 1000);
+    CHECK(test::scalar(con, "SELECT count(*) FROM t WHERE name = 'row ' || id;") == 1000);
+}
+
+TEST_CASE(caller_transaction_takes_precedence) {
+    auto con = test::memory();
+    con.execute("CREATE TABLE t(id INTEGER PRIMARY KEY, name TEXT);");
+    int commits = 0;
+    sqlite3_commit_hook(con.data(), count_commit, &commits);
+
+    sqlite::bulk_options opts;
+    opts.rows_per_transaction = 10;
+    sqlite::bulk_writer writer(con, "t", { "id", "name" }, opts);
+    {
+        auto tx = con.transaction();
+        writer.write(make_rows(100));
+        CHECK(commits == 0);
+    }
+    CHECK(commits == 0);
+    CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 0);
+}
+
+TEST_CASE(quoted_names) {
+    auto con = test::memory();
+    con.execute("CREATE TABLE \"order \"\"items\"\"\"(\"group\" INTEGER, \"select\" TEXT);");
+    sqlite::bulk_options opts;
+    opts.schema = "main";
+    sqlite::bulk_writer writer(con, "order \"items\"", { "group", "select" }, opts);
+    writer.write(make_rows(10));
+    CHECK(test::scalar(con, "SELECT count(*) FROM \"order \"\"items\"\"\";") == 10);
+}
+
+TEST_CASE(reuse_after_failure) {
+    auto con = test::memory();
+    con.execute("CREATE TABLE t(id INTEGER PRIMARY KEY, name TEXT);");
+    sqlite::bulk_writer writer(con, "t", { "id", "name" });
+    writer.write(make_rows(5));
+    CHECK_ERROR(SQLITE_CONSTRAINT_PRIMARYKEY, writer.write(make_rows(5)));
+
+    std::vector<std::tuple<int, std::string>> more = { std::make_tuple(100, "more") };
+    CHECK(writer.write(more) == 1);
+    CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 6);
+}
+
+TEST_CASE(column_count_mismatch) {
+    auto con = test::memory();
+    con.execute("CREATE TABLE t(id INTEGER PRIMARY KEY, name TEXT);");
+    sqlite::bulk_writer writer(con, "t", { "id" });
+    CHECK_ERROR(SQLITE_RANGE, writer.write(make_rows(1)));
+    CHECK_ERROR(SQLITE_MISUSE, sqlite::bulk_writer(con, "t", {}));
+}
+} // namespace
+
+int main() {
+    return test::run();
+}
@@ -0,0 +1,128 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// busy_policy: waiting on a locked database gives up once another delay would go past max_wait,
+// and the contention is counted, including after the connection is reopened.
+
+#include "test.hpp"
+
+#include <chrono>
+
+namespace {
+const char filename[] = "sqlitexx_test_busy.db";
+const char other[] = "sqlitexx_test_busy_other.db";
+
+sqlite::busy_policy short_wait() {
+    sqlite::busy_policy policy;
+    policy.initial_delay = std::chrono::microseconds(500);
+    policy.max_delay = std::chrono::milliseconds(5);
+    policy.max_wait = std::chrono::milliseconds(100);
+    return policy;
+}
+
+void create(const char* name) {
+    auto con = test::fresh(name);
+    con.execute("CREATE TABLE t(x); INSERT INTO t VALUES (1);");
+}
+
+// how long it took query to fail with SQLITE_BUSY, or a negative duration if it didn't
+std::chrono::milliseconds time_to_busy(const sqlite::connection& con, const char* query) {
+    auto start = std::chrono::steady_clock::now();
+    try {
+        con.execute(query);
+    }
+    catch(const sqlite::error& e) {
+        if((e.code() & 0xff) == SQLITE_BUSY) {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        }
+    }
+    return std::chrono::milliseconds(-1);
+}
+
+TEST_CASE(times_out_and_counts) {
+    create(filename);
+    sqlite::connection con(filename, sqlite::connection::read_write);
+    con.set_busy_policy(short_wait());
+    CHECK(con.has_busy_policy());
+
+    sqlite::connection locker(filename, sqlite::connection::read_write);
+    locker.execute("BEGIN EXCLUSIVE; INSERT INTO t VALUES (2);");
+    // the last delay is at most max_delay, so the wait ends within that of max_wait
+    auto waited = time_to_busy(con, "INSERT INTO t VALUES (3);");
+    CHECK(waited >= std::chrono::milliseconds(95));
+    CHECK(waited < std::chrono::seconds(5));
+
+    auto stats = con.busy_snapshot();
+    CHECK(stats.events == 1);
+    CHECK(stats.timeouts == 1);
+    CHECK(stats.retries > 0);
+    CHECK(stats.wait_time >= std::chrono::milliseconds(95));
+    CHECK(stats.max_wait_time <= std::chrono::milliseconds(100));
+    CHECK(stats.statements.size() == 1 && stats.statements[0].timeouts == 1);
+
+    // once the lock is gone the same statement goes through
+    locker.execute("ROLLBACK;");
+    con.execute("INSERT INTO t VALUES (3);");
+    CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 2);
+
+    con.reset_busy_stats();
+    CHECK(con.busy_snapshot().events == 0);
+    con.clear_busy_policy();
+    CHECK(!con.has_busy_policy());
+}
+
+TEST_CASE(sqlite_busy_timeout) {
+    create(filename);
+    auto policy = short_wait();
+    policy.use_busy_timeout = true;
+    sqlite::connection con(filename, sqlite::connection::read_write);
+    con.set_busy_policy(policy);
+
+    sqlite::connection locker(filename, sqlite::connection::read_write);
+    locker.execute("BEGIN EXCLUSIVE; INSERT INTO t VALUES (2);");
+    auto waited = time_to_busy(con, "INSERT INTO t VALUES (3);");
+    CHECK(waited >= std::chrono::milliseconds(90));
+    CHECK(waited < std::chrono::seconds(5));
+    locker.execute("ROLLBACK;");
+}
+
+TEST_CASE(policy_survives_reopen) {
+    create(filename);
+    create(other);
+    sqlite::connection con(filename, sqlite::connection::read_write);
+    con.set_busy_policy(short_wait());
+    con.open(other, sqlite::connection::read_write);
+    CHECK(con.has_busy_policy());
+
+    sqlite::connection locker(other, sqlite::connection::read_write);
+    locker.execute("BEGIN EXCLUSIVE; INSERT INTO t VALUES (2);");
+    auto waited = time_to_busy(con, "INSERT INTO t VALUES (3);");
+    CHECK(waited >= std::chrono::milliseconds(95));
+    CHECK(con.busy_snapshot().timeouts == 1);
+    locker.execute("ROLLBACK;");
+}
+} // namespace
+
+int main() {
+    return test::run();
+}
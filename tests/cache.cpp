@@ -0,0 +1,117 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// The statement cache: hits and misses, eviction, resizing and disabling it while statements
+// are still out, and reopening the connection onto another database.
+
+#include "test.hpp"
+
+namespace {
+const char first[] = "sqlitexx_test_cache_a.db";
+const char second[] = "sqlitexx_test_cache_b.db";
+
+TEST_CASE(hits_and_misses) {
+    auto con = test::memory();
+    con.execute("CREATE TABLE t(a); INSERT INTO t VALUES (1), (2), (3);");
+    con.enable_statement_cache(2);
+    for(int i = 0; i < 5; ++i) {
+        CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 3);
+    }
+    auto stats = con.cache_stats();
+    CHECK(stats.misses == 1);
+    CHECK(stats.hits == 4);
+
+    // the least recently used statement is evicted once the capacity is reached
+    test::scalar(con, "SELECT 1;");
+    test::scalar(con, "SELECT 2;");
+    test::scalar(con, "SELECT count(*) FROM t;");
+    CHECK(con.cache_stats().misses == 4);
+}
+
+TEST_CASE(statements_outlive_resize_and_disable) {
+    auto con = test::memory();
+    con.execute("CREATE TABLE t(a); INSERT INTO t VALUES (1), (2), (3);");
+    con.enable_statement_cache(4);
+    auto count = con.prepare_cached("SELECT count(*) FROM t;");
+    auto values = con.prepare_cached("SELECT a FROM t;");
+    con.enable_statement_cache(1);
+    con.disable_statement_cache();
+    CHECK(!con.has_statement_cache());
+
+    int rows = 0;
+    for(auto&& row : values.fetch<int>()) {
+        rows += row.get<0>();
+    }
+    CHECK(rows == 6);
+    for(auto&& row : count.fetch<int>()) {
+        CHECK(row.get<0>() == 3);
+    }
+}
+
+TEST_CASE(reopen_rebuilds_the_cache) {
+    {
+        auto a = test::fresh(first);
+        a.execute("CREATE TABLE t(x); INSERT INTO t VALUES (1);");
+        auto b = test::fresh(second);
+        b.execute("CREATE TABLE t(x); INSERT INTO t VALUES (1), (2), (3);");
+    }
+
+    sqlite::connection con(first, sqlite::connection::read_write);
+    con.enable_statement_cache(8);
+    CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 1);
+    auto held = con.prepare_cached("SELECT x FROM t;");
+
+    con.open(second, sqlite::connection::read_write);
+    CHECK(con.has_statement_cache());
+    CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 3);
+    CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 3);
+    CHECK(con.cache_stats().hits == 1);
+
+    // a statement handed out before the reopen keeps reading the old database
+    int rows = 0;
+    for(auto&& row : held.fetch<int>()) {
+        (void)row;
+        ++rows;
+    }
+    CHECK(rows == 1);
+}
+
+TEST_CASE(standalone_cache_with_two_handles) {
+    auto a = test::memory();
+    a.execute("CREATE TABLE t(x); INSERT INTO t VALUES (1);");
+    auto b = test::memory();
+    b.execute("CREATE TABLE t(x); INSERT INTO t VALUES (1), (2);");
+
+    sqlite::statement_cache cache(4);
+    for(auto&& row : cache.acquire(a.data(), "SELECT count(*) FROM t;").fetch<int>()) {
+        CHECK(row.get<0>() == 1);
+    }
+    for(auto&& row : cache.acquire(b.data(), "SELECT count(*) FROM t;").fetch<int>()) {
+        CHECK(row.get<0>() == 2);
+    }
+}
+} // namespace
+
+int main() {
+    return test::run();
+}
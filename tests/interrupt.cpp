@@ -0,0 +1,120 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// with_limits and friends: deadlines, cancellation from another thread, nesting, and telling
+// the reasons apart.
+
+#include "test.hpp"
+
+#include <sqlitexx/interrupt.hpp>
+
+#include <chrono>
+#include <thread>
+
+namespace {
+// never finishes on its own
+const char endless[] = "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c) SELECT count(*) FROM c;";
+
+// runs f and returns why it was interrupted, or -1 if it wasn't
+template<typename F>
+int reason_of(F&& f) {
+    try {
+        f();
+    }
+    catch(const sqlite::interrupted_error& e) {
+        return e.reason();
+    }
+    return -1;
+}
+
+TEST_CASE(deadline) {
+    auto con = test::memory();
+    auto start = std::chrono::steady_clock::now();
+    int why = reason_of([&] {
+        con.with_timeout(std::chrono::milliseconds(50), [&] { return test::scalar(con, endless); });
+    });
+    CHECK(why == sqlite::interrupted_error::deadline);
+    CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(50));
+
+    // a deadline that has already passed fails before anything runs
+    sqlite::query_limits limits;
+    limits.deadline = sqlite::query_limits::clock::now() - std::chrono::seconds(1);
+    bool called = false;
+    why = reason_of([&] { con.with_limits(limits, [&] { called = true; }); });
+    CHECK(why == sqlite::interrupted_error::deadline);
+    CHECK(!called);
+
+    // the connection is usable again and finished queries aren't affected
+    CHECK(con.with_timeout(std::chrono::seconds(10), [&] { return test::scalar(con, "SELECT 42;"); }) == 42);
+}
+
+TEST_CASE(cancellation) {
+    auto con = test::memory();
+    sqlite::cancellation_token token;
+    std::thread canceller([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        token.cancel();
+    });
+    int why = reason_of([&] { con.with_cancellation(token, [&] { return test::scalar(con, endless); }); });
+    canceller.join();
+    CHECK(why == sqlite::interrupted_error::cancelled);
+    CHECK(token.is_cancelled());
+
+    why = reason_of([&] { con.with_cancellation(token, [&] { return test::scalar(con, "SELECT 1;"); }); });
+    CHECK(why == sqlite::interrupted_error::cancelled);
+    token.reset();
+    CHECK(con.with_cancellation(token, [&] { return test::scalar(con, "SELECT 1;"); }) == 1);
+}
+
+TEST_CASE(nested_limits) {
+    auto con = test::memory();
+    sqlite::cancellation_token token;
+    std::thread canceller([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        token.cancel();
+    });
+    // the inner call only has a generous deadline but the outer cancellation still applies
+    int why = reason_of([&] {
+        con.with_cancellation(token, [&] {
+            con.with_timeout(std::chrono::seconds(30), [&] { return test::scalar(con, endless); });
+        });
+    });
+    canceller.join();
+    CHECK(why == sqlite::interrupted_error::cancelled);
+}
+
+TEST_CASE(plain_interrupt) {
+    auto con = test::memory();
+    std::thread interrupter([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        con.interrupt();
+    });
+    int why = reason_of([&] { con.with_timeout(std::chrono::seconds(30), [&] { return test::scalar(con, endless); }); });
+    interrupter.join();
+    CHECK(why == sqlite::interrupted_error::interrupted);
+}
+} // namespace
+
+int main() {
+    return test::run();
+}
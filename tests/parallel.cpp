@@ -0,0 +1,138 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// parallel_scan: the key ranges have to cover every row exactly once, whatever mix of
+// storage classes the key column holds.
+
+#include "test.hpp"
+
+#include <sqlitexx/parallel.hpp>
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+const char filename[] = "sqlitexx_test_parallel.db";
+
+const char query[] = "SELECT k, v FROM t WHERE k >= :lo AND k < :hi ORDER BY k;";
+
+sqlite::pool_options options() {
+    sqlite::pool_options opts;
+    opts.readers = 3;
+    return opts;
+}
+
+void fill(sqlite::connection_pool& pool, const char* key) {
+    auto writer = pool.write();
+    writer->execute("DROP TABLE IF EXISTS t; CREATE TABLE t(k, v); CREATE INDEX t_k ON t(k);");
+    writer->execute(std::string("WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c WHERE x < 300) "
+                                "INSERT INTO t SELECT ") + key + ", x FROM c;");
+}
+
+long long count_rows(const sqlite::parallel_scan& scan) {
+    return scan.reduce<long long, long long>(query, 0LL, [](long long& acc, auto&&) { ++acc; },
+                                             [](long long& result, long long partial) { result += partial; });
+}
+
+bool same_bound(const sqlite::key_bound& a, const sqlite::key_bound& b) {
+    return a.type == b.type && a.integer == b.integer && a.real == b.real && a.text == b.text;
+}
+
+// every range starts where the previous one ended and the last one is open ended
+bool contiguous(const std::vector<sqlite::key_range>& ranges) {
+    for(size_t i = 1; i < ranges.size(); ++i) {
+        if(!same_bound(ranges[i - 1].upper, ranges[i].lower)) {
+            return false;
+        }
+    }
+    return !ranges.empty() && ranges.back().upper.type == SQLITE_NULL;
+}
+
+TEST_CASE(integer_keys) {
+    test::remove_database(filename);
+    sqlite::connection_pool pool(filename, options());
+    fill(pool, "x");
+    for(size_t shards : { 1, 2, 3, 7 }) {
+        sqlite::scan_options opts;
+        opts.shards = shards;
+        sqlite::parallel_scan scan(pool, "t", "k", opts);
+        CHECK(contiguous(scan.ranges()));
+        CHECK(count_rows(scan) == 300);
+
+        // shards are concatenated in key order
+        auto rows = scan.fetch<long long, long long>(query);
+        bool sorted = rows.size() == 300;
+        for(size_t i = 0; sorted && i < rows.size(); ++i) {
+            sorted = std::get<0>(rows[i]) == static_cast<long long>(i + 1);
+        }
+        CHECK(sorted);
+    }
+}
+
+TEST_CASE(mixed_key_types) {
+    test::remove_database(filename);
+    sqlite::connection_pool pool(filename, options());
+    // a third each of integers, reals and text, the smallest and largest keys are numbers and text
+    fill(pool, "CASE x % 3 WHEN 0 THEN 'k' || x WHEN 1 THEN x ELSE x + 0.5 END");
+    for(size_t shards : { 1, 2, 3, 7 }) {
+        sqlite::scan_options opts;
+        opts.shards = shards;
+        sqlite::parallel_scan scan(pool, "t", "k", opts);
+        CHECK(contiguous(scan.ranges()));
+        CHECK(count_rows(scan) == 300);
+        CHECK(scan.fetch<long long>("SELECT v FROM t WHERE k >= :lo AND k < :hi;").size() == 300);
+    }
+}
+
+TEST_CASE(text_keys) {
+    test::remove_database(filename);
+    sqlite::connection_pool pool(filename, options());
+    fill(pool, "printf('key %05d', x)");
+    sqlite::scan_options opts;
+    opts.shards = 4;
+    sqlite::parallel_scan scan(pool, "t", "k", opts);
+    CHECK(contiguous(scan.ranges()));
+    CHECK(count_rows(scan) == 300);
+}
+
+TEST_CASE(empty_table) {
+    test::remove_database(filename);
+    sqlite::connection_pool pool(filename, options());
+    pool.write()->execute("CREATE TABLE t(k, v);");
+    sqlite::parallel_scan scan(pool, "t", "k");
+    CHECK(count_rows(scan) == 0);
+}
+
+TEST_CASE(held_lease_is_refused) {
+    test::remove_database(filename);
+    sqlite::connection_pool pool(filename, options());
+    fill(pool, "x");
+    auto lease = pool.read();
+    CHECK_ERROR(SQLITE_MISUSE, sqlite::parallel_scan(pool, "t", "k"));
+}
+} // namespace
+
+int main() {
+    return test::run();
+}
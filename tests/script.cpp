@@ -0,0 +1,112 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// Scripts: statements run one after another, named parameters, and where a failure is reported.
+
+#include "test.hpp"
+
+#include <sqlitexx/script.hpp>
+
+#include <cstring>
+#include <string>
+
+namespace {
+TEST_CASE(statements_see_earlier_ones) {
+    auto con = test::memory();
+    con.execute_script("CREATE TABLE t(a); -- a comment\n"
+                       "INSERT INTO t VALUES (:first), (:second);\n"
+                       "/* another one */ INSERT INTO t SELECT a * 10 FROM t WHERE a = :first;;",
+                       sqlite::named(":first", 1), sqlite::named(":second", 2));
+    CHECK(test::scalar(con, "SELECT sum(a) FROM t;") == 13);
+
+    int rows = 0;
+    for(auto&& row : con.fetch_script<int>("CREATE TABLE u(b); INSERT INTO u VALUES (5); SELECT b FROM u;")) {
+        CHECK(row.get<0>() == 5);
+        ++rows;
+    }
+    CHECK(rows == 1);
+    CHECK_ERROR(SQLITE_MISUSE, con.fetch_script<int>(" -- nothing here\n;"));
+}
+
+TEST_CASE(syntax_error_offset) {
+    auto con = test::memory();
+    const char sql[] = "CREATE TABLE t(a);\n"
+                       "INSERT INTO t VALUES (1);\n"
+                       "SELEC a FROM t;";
+    bool thrown = false;
+    try {
+        con.execute_script(sql);
+    }
+    catch(const sqlite::script_error& e) {
+        thrown = true;
+        CHECK(e.code() == SQLITE_ERROR);
+        CHECK(e.statement_index() == 2);
+        CHECK(e.offset() == static_cast<size_t>(std::strstr(sql, "SELEC") - sql));
+        CHECK(std::strstr(e.message(), "syntax error") != nullptr);
+    }
+    CHECK(thrown);
+    // the statements before the failing one have run
+    CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 1);
+}
+
+TEST_CASE(runtime_error_offset) {
+    auto con = test::memory();
+    const char sql[] = "CREATE TABLE t(a UNIQUE);\n"
+                       "  INSERT INTO t VALUES (1);\n"
+                       "  INSERT INTO t VALUES (1);\n"
+                       "  INSERT INTO t VALUES (2);";
+    bool thrown = false;
+    try {
+        con.execute_script(sql);
+    }
+    catch(const sqlite::script_error& e) {
+        thrown = true;
+        CHECK((e.code() & 0xff) == SQLITE_CONSTRAINT);
+        CHECK(e.statement_index() == 2);
+        // a statement that fails while running points at its start
+        CHECK(e.offset() == static_cast<size_t>(std::strstr(std::strstr(sql, "INSERT") + 1, "INSERT") - sql));
+    }
+    CHECK(thrown);
+    CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 1);
+}
+
+TEST_CASE(manual_stepping) {
+    auto con = test::memory();
+    std::string sql = "CREATE TABLE t(a); INSERT INTO t VALUES (1); SELECT a FROM t;";
+    auto s = con.script(sql);
+    size_t statements = 0;
+    while(s.next()) {
+        CHECK(s.index() == statements);
+        CHECK(sql.compare(s.offset(), 6, statements == 0 ? "CREATE" : statements == 1 ? "INSERT" : "SELECT") == 0);
+        ++statements;
+        if(!s.is_last()) {
+            s.run();
+        }
+    }
+    CHECK(statements == 3);
+}
+} // namespace
+
+int main() {
+    return test::run();
+}
@@ -0,0 +1,113 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// serialize and deserialize: round trips through an owned image, a copied buffer, a read-only
+// view, and a memory mapped WAL database.
+
+#include "test.hpp"
+
+#include <sqlitexx/serialize.hpp>
+
+#include <vector>
+
+#if SQLITEXX_HAS_SERIALIZE
+namespace {
+const char filename[] = "sqlitexx_test_serialize.db";
+
+sqlite::connection numbers() {
+    auto con = test::memory();
+    con.execute("CREATE TABLE t(x, name TEXT);"
+                "WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c WHERE x < 1000) "
+                "INSERT INTO t SELECT x, 'row ' || x FROM c;");
+    return con;
+}
+
+TEST_CASE(round_trip) {
+    auto source = numbers();
+    auto image = source.serialize();
+    CHECK(!image.empty());
+    CHECK(image.size() % 4096 == 0);
+
+    auto copy = test::memory();
+    copy.deserialize(std::move(image));
+    CHECK(image.empty());
+    CHECK(test::scalar(copy, "SELECT count(*) FROM t;") == 1000);
+    CHECK(test::scalar(copy, "SELECT sum(x) FROM t;") == 500500);
+
+    // the deserialized database stays writable and grows as needed
+    copy.execute("INSERT INTO t SELECT x + 1000, name FROM t;");
+    CHECK(test::scalar(copy, "SELECT count(*) FROM t;") == 2000);
+    CHECK(test::scalar<std::string>(copy, "PRAGMA integrity_check;") == "ok");
+}
+
+TEST_CASE(copied_buffer) {
+    auto source = numbers();
+    auto image = source.serialize();
+    std::vector<unsigned char> bytes(image.data(), image.data() + image.size());
+    image = sqlite::serialized_database();
+
+    auto copy = test::memory();
+    copy.deserialize(bytes.data(), bytes.size());
+    bytes.assign(bytes.size(), 0);
+    CHECK(test::scalar(copy, "SELECT count(*) FROM t;") == 1000);
+    copy.execute("DELETE FROM t WHERE x > 10;");
+    CHECK(test::scalar(copy, "SELECT count(*) FROM t;") == 10);
+
+    CHECK(test::memory().serialize().empty());
+}
+
+TEST_CASE(read_only_view) {
+    auto source = numbers();
+    auto image = source.serialize();
+    std::vector<unsigned char> bytes(image.data(), image.data() + image.size());
+
+    auto view = test::memory();
+    view.deserialize_view(bytes.data(), bytes.size());
+    CHECK(test::scalar(view, "SELECT count(*) FROM t;") == 1000);
+    CHECK_ERROR(SQLITE_READONLY, view.execute("DELETE FROM t;"));
+}
+
+#if SQLITEXX_HAS_MMAP
+TEST_CASE(mapped_wal_file) {
+    {
+        auto con = test::fresh(filename);
+        con.execute("PRAGMA journal_mode = WAL; CREATE TABLE t(x);"
+                    "INSERT INTO t VALUES (1), (2), (3);");
+    }
+
+    sqlite::mapped_file file(filename);
+    auto view = test::memory();
+    view.deserialize_view(file);
+    CHECK(test::scalar(view, "SELECT sum(x) FROM t;") == 6);
+
+    // the header is only switched in the mapping, the file on disk is still in WAL mode
+    sqlite::connection con(filename, sqlite::connection::read_write);
+    CHECK(test::scalar<std::string>(con, "PRAGMA journal_mode;") == "wal");
+}
+#endif
+} // namespace
+#endif
+
+int main() {
+    return test::run();
+}
@@ -0,0 +1,135 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// A minimal test harness shared by the tests in this directory. Every test file registers
+// its cases with TEST_CASE and runs them from main through test::run, which prints each
+// failed check and returns non-zero if any case failed. Databases that need to live on
+// disk are created in the working directory, which ctest sets to the build directory.
+
+#pragma once
+
+#include <sqlitexx/connection.hpp>
+
+#include <cstdio>
+#include <exception>
+#include <string>
+#include <vector>
+
+namespace test {
+struct test_case {
+    const char* name;
+    void (*body)();
+};
+
+inline std::vector<test_case>& registry() {
+    static std::vector<test_case> cases;
+    return cases;
+}
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+struct registrar {
+    registrar(const char* name, void (*body)()) {
+        registry().push_back({ name, body });
+    }
+};
+
+inline void check(bool ok, const char* expr, const char* file, int line) {
+    if(!ok) {
+        std::printf("%s:%d: check failed: %s\n", file, line, expr);
+        ++failures();
+    }
+}
+
+inline int run() {
+    int failed = 0;
+    for(auto&& c : registry()) {
+        int before = failures();
+        try {
+            c.body();
+        }
+        catch(const std::exception& e) {
+            std::printf("%s: unexpected exception: %s\n", c.name, e.what());
+            ++failures();
+        }
+
+        bool ok = failures() == before;
+        failed += !ok;
+        std::printf("[%s] %s\n", ok ? "  ok  " : " FAIL ", c.name);
+    }
+    std::printf("%d of %d cases failed\n", failed, static_cast<int>(registry().size()));
+    return failed == 0 ? 0 : 1;
+}
+
+inline void remove_database(const std::string& filename) {
+    std::remove(filename.c_str());
+    std::remove((filename + "-wal").c_str());
+    std::remove((filename + "-shm").c_str());
+    std::remove((filename + "-journal").c_str());
+}
+
+inline sqlite::connection memory() {
+    return sqlite::connection(":memory:", sqlite::connection::read_write | sqlite::connection::create);
+}
+
+// a fresh database on disk, removed first in case an earlier run left it behind
+inline sqlite::connection fresh(const std::string& filename) {
+    remove_database(filename);
+    return sqlite::connection(filename, sqlite::connection::read_write | sqlite::connection::create);
+}
+
+// the single value of a query returning one row and one column
+template<typename T = long long, typename String>
+T scalar(const sqlite::connection& con, const String& query) {
+    T result{};
+    for(auto&& row : con.fetch<T>(query)) {
+        result = row.template get<0>();
+    }
+    return result;
+}
+} // test
+
+#define TEST_CASE(name)                                                               \
+    static void name();                                                               \
+    static ::test::registrar name##_registrar(#name, name);                           \
+    static void name()
+
+#define CHECK(expr) ::test::check(static_cast<bool>(expr), #expr, __FILE__, __LINE__)
+
+// checks that expr throws an sqlite::error carrying the error code ec
+#define CHECK_ERROR(ec, expr)                                                         \
+    do {                                                                              \
+        int check_error_code = SQLITE_OK;                                             \
+        try {                                                                         \
+            expr;                                                                     \
+        }                                                                             \
+        catch(const ::sqlite::error& e) {                                             \
+            check_error_code = e.code();                                              \
+        }                                                                             \
+        bool check_error_ok = check_error_code == (ec);                               \
+        ::test::check(check_error_ok, #expr " fails with " #ec, __FILE__, __LINE__);  \
+    }                                                                                 \
+    while(0)
@@ -0,0 +1,141 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// Transactions and savepoints: commits, rollbacks on destruction, nesting, and reopening the
+// connection while one is active.
+
+#include "test.hpp"
+
+namespace {
+const char first[] = "sqlitexx_test_transaction_a.db";
+const char second[] = "sqlitexx_test_transaction_b.db";
+
+sqlite::connection numbers(int count) {
+    auto con = test::memory();
+    con.execute("CREATE TABLE t(x);");
+    auto stmt = con.prepare("INSERT INTO t VALUES (?);");
+    for(int i = 0; i < count; ++i) {
+        stmt.execute(i);
+    }
+    return con;
+}
+
+TEST_CASE(commit_and_rollback) {
+    auto con = numbers(3);
+    {
+        auto tx = con.transaction();
+        con.execute("INSERT INTO t VALUES (10);");
+        tx.commit();
+    }
+    CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 4);
+    {
+        auto tx = con.transaction(sqlite::transaction::immediate);
+        con.execute("DELETE FROM t;");
+    }
+    CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 4);
+    {
+        sqlite::transaction tx(con);
+        con.execute("DELETE FROM t;");
+        tx.rollback();
+        tx.commit();
+    }
+    CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 4);
+}
+
+TEST_CASE(nested_savepoints) {
+    auto con = numbers(3);
+    {
+        auto outer = con.savepoint();
+        con.execute("INSERT INTO t VALUES (10);");
+        {
+            auto inner = con.savepoint();
+            CHECK(inner.depth() == outer.depth() + 1);
+            con.execute("DELETE FROM t;");
+        }
+        CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 4);
+        {
+            auto inner = con.savepoint();
+            con.execute("INSERT INTO t VALUES (11);");
+            inner.commit();
+        }
+        CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 5);
+    }
+    // the outermost savepoint started the transaction and rolled all of it back
+    CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 3);
+    CHECK(sqlite3_get_autocommit(con.data()) != 0);
+}
+
+TEST_CASE(savepoint_inside_transaction) {
+    auto con = numbers(3);
+    {
+        auto tx = con.transaction();
+        {
+            auto sp = con.savepoint();
+            con.execute("DELETE FROM t;");
+            sp.rollback();
+        }
+        con.execute("INSERT INTO t VALUES (10);");
+        tx.commit();
+    }
+    CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 4);
+}
+
+TEST_CASE(reopen_rebinds_control_statements) {
+    {
+        auto a = test::fresh(first);
+        a.execute("CREATE TABLE t(x); INSERT INTO t VALUES (1);");
+        auto b = test::fresh(second);
+        b.execute("CREATE TABLE t(x); INSERT INTO t VALUES (1), (2), (3);");
+    }
+
+    sqlite::connection con(first, sqlite::connection::read_write);
+    {
+        auto tx = con.transaction();
+        con.execute("INSERT INTO t VALUES (2);");
+        tx.commit();
+    }
+
+    con.open(second, sqlite::connection::read_write);
+    {
+        auto tx = con.transaction();
+        con.execute("DELETE FROM t;");
+    }
+    CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 3);
+    {
+        auto sp = con.savepoint();
+        con.execute("DELETE FROM t;");
+    }
+    CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 3);
+
+    // reopening in the middle of a transaction is refused and leaves the connection alone
+    {
+        auto tx = con.transaction();
+        CHECK_ERROR(SQLITE_MISUSE, con.open(first, sqlite::connection::read_write));
+    }
+    CHECK(test::scalar(con, "SELECT count(*) FROM t;") == 3);
+}
+} // namespace
+
+int main() {
+    return test::run();
+}
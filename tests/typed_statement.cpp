@@ -0,0 +1,89 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// typed_statement: the signature is checked against the statement once, then binding and
+// fetching go through the declared types.
+
+#include "test.hpp"
+
+#include <sqlitexx/typed_statement.hpp>
+
+#include <string>
+
+namespace {
+using sqlite::params;
+using sqlite::row;
+
+TEST_CASE(bind_and_fetch) {
+    auto con = test::memory();
+    con.execute("CREATE TABLE t(id INTEGER PRIMARY KEY, name TEXT, score REAL);");
+    auto insert = con.prepare_typed<params(long long, std::string, double), row()>("INSERT INTO t VALUES (?, ?, ?);");
+    insert.execute(1, "one", 1.5);
+    insert.execute(2, "two", 2.5);
+
+    auto select = con.prepare_typed<params(long long), row(std::string, double)>("SELECT name, score FROM t WHERE id >= ?;");
+    int rows = 0;
+    for(auto&& r : select.fetch(2)) {
+        CHECK(r.get<0>() == "two");
+        CHECK(r.get<1>() == 2.5);
+        ++rows;
+    }
+    CHECK(rows == 1);
+
+    // a fetch abandoned halfway doesn't stop the statement from being bound again
+    for(auto&& r : select.fetch(1)) {
+        (void)r;
+        break;
+    }
+    rows = 0;
+    for(auto&& r : select.fetch(1)) {
+        (void)r;
+        ++rows;
+    }
+    CHECK(rows == 2);
+
+    CHECK_ERROR(SQLITE_CONSTRAINT_PRIMARYKEY, insert.execute(1, "again", 0.0));
+}
+
+TEST_CASE(count_mismatch) {
+    auto con = test::memory();
+    con.execute("CREATE TABLE t(a, b);");
+    auto too_many_params = [&] { con.prepare_typed<params(int, int), row()>("INSERT INTO t(a) VALUES (?);"); };
+    auto too_few_params = [&] { con.prepare_typed<params(), row()>("INSERT INTO t(a) VALUES (?);"); };
+    auto too_many_columns = [&] { con.prepare_typed<params(), row(int, int, int)>("SELECT a, b FROM t;"); };
+    auto too_few_columns = [&] { con.prepare_typed<params(), row(int)>("SELECT a, b FROM t;"); };
+    CHECK_ERROR(SQLITE_RANGE, too_many_params());
+    CHECK_ERROR(SQLITE_RANGE, too_few_params());
+    CHECK_ERROR(SQLITE_RANGE, too_many_columns());
+    CHECK_ERROR(SQLITE_RANGE, too_few_columns());
+
+    using exact = sqlite::typed_statement<params(int), row(int, int)>;
+    exact stmt(con.prepare("SELECT a, b FROM t WHERE a = ?;"));
+    CHECK(exact::parameter_count == 1);
+    CHECK(exact::column_count == 2);
+}
+} // namespace
+
+int main() {
+    return test::run();
+}
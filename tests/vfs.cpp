@@ -0,0 +1,156 @@
+// The MIT License (MIT)
+
+// Copyright (c) 2017 Danny Y.
+
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+
+// vfs_shim and io_stats_vfs: registration, intercepting files, and the I/O counters with and
+// without write coalescing and read-ahead.
+
+#include "test.hpp"
+
+#include <sqlitexx/vfs.hpp>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+const char filename[] = "sqlitexx_test_vfs.db";
+
+// counts the files it opened and closed
+struct counting_shim : sqlite::vfs_shim {
+    struct file : sqlite::vfs_file {
+        file(counting_shim& owner, sqlite3_file* base, const char* name, int flags):
+            sqlite::vfs_file(base, name, flags), owner(owner) {}
+
+        int close() override {
+            ++owner.closes;
+            return sqlite::vfs_file::close();
+        }
+
+        counting_shim& owner;
+    };
+
+    explicit counting_shim(std::string name): sqlite::vfs_shim(std::move(name)) {
+        install();
+    }
+
+    ~counting_shim() override {
+        uninstall();
+    }
+
+    std::atomic<int> opens{0};
+    std::atomic<int> closes{0};
+protected:
+    std::unique_ptr<sqlite::vfs_file> open_file(sqlite3_file* base, const char* name, int flags) override {
+        ++opens;
+        return std::make_unique<file>(*this, base, name, flags);
+    }
+};
+
+void load(const char* vfs) {
+    test::remove_database(filename);
+    sqlite::connection con(filename, sqlite::connection::read_write | sqlite::connection::create, vfs);
+    con.execute("PRAGMA journal_mode = WAL; CREATE TABLE t(id INTEGER PRIMARY KEY, name TEXT);");
+    auto stmt = con.prepare("INSERT INTO t(name) VALUES (?);");
+    for(int i = 0; i < 2000; i += 100) {
+        auto tx = con.transaction();
+        for(int j = i; j < i + 100; ++j) {
+            stmt.execute("row number " + std::to_string(j));
+        }
+        tx.commit();
+    }
+}
+
+long long scan(const char* vfs) {
+    sqlite::connection con(filename, sqlite::connection::read_write, vfs);
+    con.execute("PRAGMA cache_size = 8;");
+    return test::scalar(con, "SELECT sum(length(name)) FROM t;");
+}
+
+// the counters of the database file or its WAL, ignoring anything else that was opened
+sqlite::file_io_stats find(const sqlite::io_stats_vfs& stats, int type) {
+    for(auto&& file : stats.snapshot()) {
+        if(file.type == type && file.name.find(filename) != std::string::npos) {
+            return file;
+        }
+    }
+    return {};
+}
+
+TEST_CASE(shim_registration) {
+    {
+        counting_shim shim("sqlitexx_test_counting");
+        CHECK(sqlite3_vfs_find("sqlitexx_test_counting") != nullptr);
+        CHECK(shim.parent() == sqlite3_vfs_find(nullptr));
+        load(shim.name());
+        CHECK(shim.opens > 0);
+        CHECK(shim.opens == shim.closes);
+    }
+    CHECK(sqlite3_vfs_find("sqlitexx_test_counting") == nullptr);
+    CHECK_ERROR(SQLITE_ERROR, sqlite::vfs_shim("sqlitexx_test_orphan", "no such parent"));
+    CHECK_ERROR(SQLITE_ERROR, load("no such vfs"));
+}
+
+TEST_CASE(io_counters) {
+    sqlite::io_stats_vfs stats("sqlitexx_test_io");
+    load(stats.name());
+    auto wal = find(stats, SQLITE_OPEN_WAL);
+    CHECK(wal.opens == 1);
+    CHECK(wal.writes.calls > 20);
+    CHECK(wal.writes.bytes >= wal.writes.calls);
+    CHECK(wal.syncs.calls >= 1);
+    CHECK(wal.coalesced_writes == 0);
+    CHECK(find(stats, SQLITE_OPEN_MAIN_DB).opens == 1);
+
+    stats.reset();
+    CHECK(scan(stats.name()) > 0);
+    auto db = find(stats, SQLITE_OPEN_MAIN_DB);
+    CHECK(db.opens == 1);
+    CHECK(db.reads.calls > 8);
+    CHECK(db.reads.bytes >= db.reads.calls * 512);
+    CHECK(db.writes.calls == 0);
+    CHECK(db.readahead_hits == 0);
+}
+
+TEST_CASE(coalescing_and_readahead) {
+    load(nullptr);
+    auto expected = scan(nullptr);
+
+    sqlite::io_stats_options opts;
+    opts.coalesce_bytes = 64 * 1024;
+    opts.readahead_bytes = 64 * 1024;
+    sqlite::io_stats_vfs stats("sqlitexx_test_tuned", opts);
+    load(stats.name());
+    CHECK(find(stats, SQLITE_OPEN_WAL).coalesced_writes > 0);
+
+    // what was written through the shim reads back the same without it, and through it
+    CHECK(scan(nullptr) == expected);
+    stats.reset();
+    CHECK(scan(stats.name()) == expected);
+    CHECK(find(stats, SQLITE_OPEN_MAIN_DB).readahead_hits > 0);
+}
+} // namespace
+
+int main() {
+    return test::run();
+}